@@ -2,6 +2,7 @@
 #include <cmath>
 
 #include "Actor.h"
+#include "AntProgram.h"
 #include "StudentWorld.h"
 #include "GameConstants.h"
 
@@ -24,7 +25,7 @@ Actor::Direction Actor::randomDirection() const {
   // Choose a random direction by choosing a random direction from the enum
   // class based on the integer value of each enum element. (with up being of
   // least value 1 and left being of greatest value 4)
-  return static_cast<Actor::Direction>(randInt(1, 4));
+  return static_cast<Actor::Direction>(getStudentWorld().randInt(1, 4));
 }
 bool Actor::checkForObjectMatch(ActorType type) const {
   return actor_type_ == type;
@@ -37,13 +38,17 @@ void Actor::changePoints(int delta) {
 void Actor::moveTo(Coordinate coord) {
   // Cap X and Y within bounds.
   coord.setX(std::max(0, coord.getX()));
-  coord.setX(std::min(VIEW_WIDTH, coord.getX()));
+  coord.setX(std::min(VIEW_WIDTH - 1, coord.getX()));
   coord.setY(std::max(0, coord.getY()));
-  coord.setY(std::min(VIEW_HEIGHT, coord.getY()));
+  coord.setY(std::min(VIEW_HEIGHT - 1, coord.getY()));
 
   student_world_.updatePositionInGrid(this, coord);
 }
-void Actor::die() { dead_ = true; setVisible(false); }
+void Actor::die() {
+  dead_ = true;
+  setVisible(false);
+  student_world_.updateDeathInGrid(this);
+}
 void Actor::bite(Actor *bit_by, int damage) {
   // Actor defaults to doing nothing when bitten.
 }
@@ -69,6 +74,13 @@ Poison::Poison(StudentWorld &student_world, Coordinate coord)
     : Actor(student_world, ActorType::POISON, IID_POISON, coord,
             kObjectStartingDirection, kDepth, kInitialPoints) {}
 void Poison::doSomething() {
+  // Most of the time there are no insects here to poison, which the mask of
+  // the types at the coordinate tells without searching for them.
+  std::uint32_t insect_types = ActorCell::typeBit(ActorType::GRASSHOPPER);
+  for (int i = 0; i < 4; i++)
+    insect_types |= ActorCell::typeBit(Ant::getActorTypeFromColony(i));
+  if ((getStudentWorld().actorTypesAt(getCoord()) & insect_types) == 0) return;
+
   // Generate a list of all types of insects.
   std::vector<ActorType> insects;
   insects.push_back(ActorType::GRASSHOPPER);
@@ -92,6 +104,12 @@ WaterPool::WaterPool(StudentWorld &student_world, Coordinate coord)
     : Actor(student_world, ActorType::WATER_POOL, IID_WATER_POOL, coord,
             kObjectStartingDirection, kDepth, kInitialPoints) {}
 void WaterPool::doSomething() {
+  // Only ants are stunned, and most of the time there are none here.
+  std::uint32_t ant_types = 0;
+  for (int i = 0; i < 4; i++)
+    ant_types |= ActorCell::typeBit(Ant::getActorTypeFromColony(i));
+  if ((getStudentWorld().actorTypesAt(getCoord()) & ant_types) == 0) return;
+
   // Generate a list of all types of insects.
   std::vector<ActorType> insects;
   for (int i = 0; i < 4; i++) {
@@ -131,10 +149,12 @@ int Pheromone::getImageForColony(int colony) {
 }
 
 AntHill::AntHill(StudentWorld &student_world, int colony, Coordinate coord,
-                 Compiler *compiler)
+                 const AntProgram *program, int population_scale)
     : Actor(student_world, getActorTypeFromColony(colony), IID_ANT_HILL, coord,
-            kObjectStartingDirection, kDepth, kInitialHitPoints),
-      compiler_(compiler),
+            kObjectStartingDirection, kDepth,
+            kReserveHitPoints +
+                population_scale * (kInitialHitPoints - kReserveHitPoints)),
+      program_(program),
       colony_(colony) {}
 
 void AntHill::doSomething() {
@@ -165,7 +185,7 @@ void AntHill::giveBirth() {
   // Add a new ant on top of the ant hill and update the scoreboard to account
   // for this ant hill's success in producing a new ant.
   getStudentWorld().addActor(new Ant(getStudentWorld(), colony_, getCoord(),
-                                     compiler_, *this, kAntHitPoints));
+                                     program_, *this, kAntHitPoints));
   getStudentWorld().updateScoreboard(colony_);
 }
 
@@ -217,11 +237,12 @@ void Insect::bite(Actor *actor, int damage) { changePoints(-1 * damage); }
 void Insect::poison() { changePoints(-1 * kPoisonDamage); }
 
 Ant::Ant(StudentWorld &student_world, int colony, Coordinate coord,
-         Compiler *compiler, AntHill &my_ant_hill, int hit_points)
+         const AntProgram *program, AntHill &my_ant_hill, int hit_points)
     : Insect(student_world, getImageForColony(colony), coord,
-             getActorTypeFromColony(colony), static_cast<Actor::Direction>(randInt(1, 4)), kDepth,
-             hit_points),
-      compiler_(compiler),
+             getActorTypeFromColony(colony),
+             static_cast<Actor::Direction>(student_world.randInt(1, 4)),
+             kDepth, hit_points),
+      program_(program),
       my_ant_hill_(my_ant_hill),
       blocked_by_pebble_(false),
       was_bit_(false),
@@ -242,6 +263,12 @@ Ant::Ant(StudentWorld &student_world, int colony, Coordinate coord,
       break;
     }
   }
+
+  other_insects_mask_ = 0;
+  for (int i = 0; i < other_insects_.size(); i++)
+    other_insects_mask_ |= ActorCell::typeBit(other_insects_[i]);
+  pheromone_type_ = Pheromone::getActorType(colony);
+  ant_hill_type_ = AntHill::getActorTypeFromColony(colony);
 }
 
 void Ant::doSomething() {
@@ -253,18 +280,15 @@ void Ant::doSomething() {
 
   if (sleep()) return;
 
-  if(compiler_ == nullptr) return;
+  if (program_ == nullptr) return;
 
-  // Run commands until an action is perform by the ant, up to a total of 10
-  // commands.
-  Compiler::Command command;
-  int commands_this_tick = 0;
-  do {
-    if (!compiler_->getCommand(instruction_counter_++, command)) {
-      die();
-      return;
-    }
-  } while (runCommand(command) && ++commands_this_tick < 10);
+  // Run instructions until an action is perform by the ant, up to a total of
+  // 10 instructions. Running off either end of the program kills the ant.
+  int instructions_this_tick = 0;
+  if (!program_->run(*this, instruction_counter_, instructions_this_tick))
+    die();
+
+  getStudentWorld().countInstructions(instructions_this_tick);
 }
 
 ActorType Ant::getActorTypeFromColony(int colony) {
@@ -274,251 +298,182 @@ ActorType Ant::getActorTypeFromColony(int colony) {
 }
 
 int Ant::getColonyFromActorType(ActorType actor_type) {
-  std::map<ActorType, int> ant_actor_type_to_colony = {{ActorType::ANT0, 0},
-                                                       {ActorType::ANT1, 1},
-                                                       {ActorType::ANT2, 2},
-                                                       {ActorType::ANT3, 3}};
+  // The ant types are listed in order of colony.
+  return static_cast<int>(actor_type) - static_cast<int>(ActorType::ANT0);
+}
 
-  return ant_actor_type_to_colony[actor_type];
+bool Ant::smellDangerInFront() {
+  // Check to see if there are enemy insects, water, or poison in the square
+  // directly in front of the insect.
+  Coordinate coord_in_front = getCoord().coordInDirection(getDirection());
+  std::uint32_t stranger_danger = other_insects_mask_ |
+                                  ActorCell::typeBit(ActorType::WATER_POOL) |
+                                  ActorCell::typeBit(ActorType::POISON);
+
+  return (getStudentWorld().actorTypesAt(coord_in_front) & stranger_danger) !=
+         0;
 }
 
-bool Ant::runCommand(const Compiler::Command &c) {
-  switch (c.opcode) {
-    case Compiler::goto_command: {
-      // Set the next instruction to the one specified by the operand.
-      instruction_counter_ = stoi(c.operand1);
-      return true;
-    }
-    case Compiler::if_command: {
-      switch (stoi(c.operand1)) {
-        // If any of these cases are true, jump to the instruction specified.
-
-        case Compiler::i_smell_danger_in_front_of_me: {
-          // Check to see if there are enemy insects, water, or poison in the
-          // square directly in front of the insect.
-          Coordinate coord_in_front =
-              getCoord().coordInDirection(getDirection());
-
-          std::vector<ActorType> stranger_danger = other_insects_;
-          stranger_danger.push_back(ActorType::WATER_POOL);
-          stranger_danger.push_back(ActorType::POISON);
-
-          if (getStudentWorld()
-                  .actorsOfTypesAt(stranger_danger, coord_in_front)
-                  .size() > 0)
-            instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::i_smell_pheromone_in_front_of_me: {
-          // Search for pheromones on the current coordinate.
-          Coordinate coord_in_front =
-              getCoord().coordInDirection(getDirection());
-          std::list<Actor *> pheromone = getStudentWorld().actorsOfTypeAt(
-              Pheromone::getActorType(getColonyFromActorType(getActorType())),
-              coord_in_front);
-
-          if (pheromone.size() > 0) {
-            // Do not account for pheromones with no strength.
-            if ((*pheromone.begin())->getPoints() < 1) break;
-            instruction_counter_ = stoi(c.operand2);
-          }
-          break;
-        }
-        case Compiler::i_was_bit: {
-          if (was_bit_) instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::i_am_carrying_food: {
-          if (food_carried_ > 0) instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::i_am_hungry: {
-          if (getPoints() <= kHungerThreshold)
-            instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::i_am_standing_on_my_anthill: {
-          // Search for an ant hill at the current coordinate that corresponds
-          // to this ant's colony.
-          std::list<Actor *> anthill = getStudentWorld().actorsOfTypeAt(
-              AntHill::getActorTypeFromColony(
-                  getColonyFromActorType(getActorType())),
-              getCoord());
-
-          if (anthill.size() > 0) {
-            if ((*anthill.begin())->dead()) break;
-
-            instruction_counter_ = stoi(c.operand2);
-          }
-          break;
-        }
-        case Compiler::i_am_standing_on_food: {
-          // Search for food at the current coordinate.
-          std::list<Actor *> food =
-              getStudentWorld().actorsOfTypeAt(ActorType::FOOD, getCoord());
-
-          if (food.size() > 0) {
-            // Don't count food that has no energy stored.
-            if ((*food.begin())->getPoints() < 1) break;
-            instruction_counter_ = stoi(c.operand2);
-          }
-          break;
-        }
-        case Compiler::i_am_standing_with_an_enemy: {
-          // Search for enemies at the current coordinate.
-          std::list<Actor *> enemies =
-              getStudentWorld().actorsOfTypesAt(other_insects_, getCoord());
-
-          // Make sure at least one of the enemies in the list is alive.
-          bool alive_enemy = false;
-          for (std::list<Actor *>::const_iterator i = enemies.begin();
-               i != enemies.end(); i++) {
-            if (!(*i)->dead()) {
-              alive_enemy = true;
-              break;
-            }
-          }
-
-          if(alive_enemy) instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::i_was_blocked_from_moving: {
-          if (blocked_by_pebble_) instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-        case Compiler::last_random_number_was_zero: {
-          if (last_random_number_ == 0) instruction_counter_ = stoi(c.operand2);
-          break;
-        }
-      }
+bool Ant::smellPheromoneInFront() {
+  // Search for pheromones on the square in front.
+  Coordinate coord_in_front = getCoord().coordInDirection(getDirection());
+  Actor *pheromone =
+      getStudentWorld().actorOfTypeAt(pheromone_type_, coord_in_front);
 
-      return true;
-    }
-    case Compiler::invalid: {
-      std::cerr << "INVALID COMMAND" << std::endl;
-      die();
-      return false;
-    }
-    case Compiler::rotateClockwise: {
-      // Rotate clockwise by increasing the direction enum value. If the raw
-      // direction number maxes out (when it equals left), wrap so that the next
-      // direction is up.
-      int direction_int = static_cast<int>(getDirection());
-      direction_int++;
-      if (static_cast<Actor::Direction>(direction_int) ==
-          Actor::Direction::left)
-        direction_int = Actor::Direction::up;
-
-      setDirection(static_cast<Actor::Direction>(direction_int));
-      return false;
-    }
-    case Compiler::rotateCounterClockwise: {
-      // Rotate counterclockwise by decreasing the direction enum value. If the
-      // raw direction number reaches minimum (when it equals up), wrap so that
-      // the next direction is left.
-      int direction_int = static_cast<int>(getDirection());
-      direction_int--;
-      if (static_cast<Actor::Direction>(direction_int) == Actor::Direction::up)
-        direction_int = Actor::Direction::left;
-
-      setDirection(static_cast<Actor::Direction>(direction_int));
-      return false;
-    }
-    case Compiler::faceRandomDirection: {
-      setDirection(randomDirection());
-      return false;
-    }
-    case Compiler::emitPheromone: {
-      getStudentWorld().addPheromone(
-          getCoord(), kPheromoneStrength,
-          getColonyFromActorType(Actor::getActorType()));
-      return false;
-    }
-    case Compiler::dropFood: {
-      getStudentWorld().addFood(getCoord(), food_carried_);
-      food_carried_ = 0;
-      return false;
-    }
-    case Compiler::moveForward: {
-      blocked_by_pebble_ = false;
-
-      // Attempt to move one square in the current direction.
-      int x = getX(), y = getY();
-      switch (getDirection()) {
-        case Direction::right:
-          x++;
-          break;
-        case Direction::left:
-          x--;
-          break;
-        case Direction::up:
-          y++;
-          break;
-        case Direction::down:
-          y--;
-          break;
-        default:
-          break;
-      }
+  // Do not account for pheromones with no strength.
+  return pheromone != nullptr && pheromone->getPoints() >= 1;
+}
 
-      // Check to see if a pebble is blocking the path.
-      std::list<Actor *> pebbles_in_direction =
-          getStudentWorld().actorsOfTypeAt(ActorType::PEBBLE, Coordinate(x, y));
-      if (pebbles_in_direction.size() > 0) {
-        blocked_by_pebble_ = true;  // Remember the block for the next tick.
-        return false;
-      }
+bool Ant::wasBit() const { return was_bit_; }
 
-      // Move was successful, so reset conditions that only lasted when the ant
-      // had not moved from the current square and proceed to move the ant to
-      // the new square.
-      resetStunned();
-      was_bit_ = false;
-      moveTo(Coordinate(x, y));
-      return false;
-    }
-    case Compiler::label:
-      return false;
-    case Compiler::bite: {
-      // Find enemy actors at the given coordinate to bite.
-      std::list<Actor *> other_insects_at_point =
-          getStudentWorld().actorsOfTypesAt(other_insects_, getCoord());
-
-      for (std::list<Actor *>::const_iterator i =
-               other_insects_at_point.begin();
-           i != other_insects_at_point.end(); i++) {
-        if ((*i)->dead()) continue;
-        (*i)->bite(this, kBiteStrength);
-      }
+bool Ant::isCarryingFood() const { return food_carried_ > 0; }
 
-      return false;
-    }
-    case Compiler::pickupFood: {
-      std::list<Actor *> food_at_point =
-          getStudentWorld().actorsOfTypeAt(ActorType::FOOD, getCoord());
-      if (food_at_point.size() < 1) return false;  // No food at point.
-
-      int held_food = (*food_at_point.begin())->getPoints();
-      held_food = std::min(held_food, kMaxFoodPerPickup);
-      held_food = std::min(held_food, kMaxTotalCarryingFood - food_carried_);
-      food_carried_ += held_food;
-      (*food_at_point.begin())->changePoints(-1 * held_food);
-
-      return false;
-    }
-    case Compiler::eatFood: {
-      int food_eaten = std::min(food_carried_, kMaxFoodPerEating);
-      changePoints(food_eaten);
-      food_carried_ -= food_eaten;
+bool Ant::isHungry() const { return getPoints() <= kHungerThreshold; }
 
-      return false;
-    }
-    case Compiler::generateRandomNumber: {
-      last_random_number_ = randInt(0, stoi(c.operand1) - 1);
+bool Ant::isStandingOnMyAntHill() {
+  // Search for an ant hill at the current coordinate that corresponds to this
+  // ant's colony.
+  Actor *anthill = getStudentWorld().actorOfTypeAt(ant_hill_type_, getCoord());
 
-      return false;
-    }
+  return anthill != nullptr && !anthill->dead();
+}
+
+bool Ant::isStandingOnFood() {
+  // Search for food at the current coordinate.
+  Actor *food = getStudentWorld().actorOfTypeAt(ActorType::FOOD, getCoord());
+
+  // Don't count food that has no energy stored.
+  return food != nullptr && food->getPoints() >= 1;
+}
+
+bool Ant::isStandingWithEnemy() {
+  // Most squares hold no enemies at all, which the mask of the types on the
+  // square tells without looking at the actors.
+  if ((getStudentWorld().actorTypesAt(getCoord()) & other_insects_mask_) == 0)
+    return false;
+
+  // Search for enemies at the current coordinate.
+  std::list<Actor *> enemies =
+      getStudentWorld().actorsOfTypesAt(other_insects_, getCoord());
+
+  // Make sure at least one of the enemies in the list is alive.
+  for (std::list<Actor *>::const_iterator i = enemies.begin();
+       i != enemies.end(); i++) {
+    if (!(*i)->dead()) return true;
   }
+
+  return false;
+}
+
+bool Ant::wasBlockedFromMoving() const { return blocked_by_pebble_; }
+
+bool Ant::lastRandomNumberWasZero() const { return last_random_number_ == 0; }
+
+void Ant::rotateClockwise() {
+  // Rotate clockwise by increasing the direction enum value. If the raw
+  // direction number maxes out (when it equals left), wrap so that the next
+  // direction is up.
+  int direction_int = static_cast<int>(getDirection());
+  direction_int++;
+  if (static_cast<Actor::Direction>(direction_int) == Actor::Direction::left)
+    direction_int = Actor::Direction::up;
+
+  setDirection(static_cast<Actor::Direction>(direction_int));
+}
+
+void Ant::rotateCounterClockwise() {
+  // Rotate counterclockwise by decreasing the direction enum value. If the raw
+  // direction number reaches minimum (when it equals up), wrap so that the
+  // next direction is left.
+  int direction_int = static_cast<int>(getDirection());
+  direction_int--;
+  if (static_cast<Actor::Direction>(direction_int) == Actor::Direction::up)
+    direction_int = Actor::Direction::left;
+
+  setDirection(static_cast<Actor::Direction>(direction_int));
+}
+
+void Ant::faceRandomDirection() { setDirection(randomDirection()); }
+
+void Ant::emitPheromone() {
+  getStudentWorld().addPheromone(getCoord(), kPheromoneStrength,
+                                 getColonyFromActorType(Actor::getActorType()));
+}
+
+void Ant::dropFood() {
+  getStudentWorld().addFood(getCoord(), food_carried_);
+  food_carried_ = 0;
+}
+
+void Ant::moveForward() {
+  blocked_by_pebble_ = false;
+
+  // Attempt to move one square in the current direction.
+  int x = getX(), y = getY();
+  switch (getDirection()) {
+    case Direction::right:
+      x++;
+      break;
+    case Direction::left:
+      x--;
+      break;
+    case Direction::up:
+      y++;
+      break;
+    case Direction::down:
+      y--;
+      break;
+    default:
+      break;
+  }
+
+  // Check to see if a pebble is blocking the path.
+  if (getStudentWorld().actorTypesAt(Coordinate(x, y)) &
+      ActorCell::typeBit(ActorType::PEBBLE)) {
+    blocked_by_pebble_ = true;  // Remember the block for the next tick.
+    return;
+  }
+
+  // Move was successful, so reset conditions that only lasted when the ant
+  // had not moved from the current square and proceed to move the ant to the
+  // new square.
+  resetStunned();
+  was_bit_ = false;
+  moveTo(Coordinate(x, y));
+}
+
+void Ant::biteEnemy() {
+  // Find enemy actors at the given coordinate to bite.
+  std::list<Actor *> other_insects_at_point =
+      getStudentWorld().actorsOfTypesAt(other_insects_, getCoord());
+
+  for (std::list<Actor *>::const_iterator i = other_insects_at_point.begin();
+       i != other_insects_at_point.end(); i++) {
+    if ((*i)->dead()) continue;
+    (*i)->bite(this, kBiteStrength);
+  }
+}
+
+void Ant::pickUpFood() {
+  std::list<Actor *> food_at_point =
+      getStudentWorld().actorsOfTypeAt(ActorType::FOOD, getCoord());
+  if (food_at_point.size() < 1) return;  // No food at point.
+
+  int held_food = (*food_at_point.begin())->getPoints();
+  held_food = std::min(held_food, kMaxFoodPerPickup);
+  held_food = std::min(held_food, kMaxTotalCarryingFood - food_carried_);
+  food_carried_ += held_food;
+  (*food_at_point.begin())->changePoints(-1 * held_food);
+}
+
+void Ant::eatFood() {
+  int food_eaten = std::min(food_carried_, kMaxFoodPerEating);
+  changePoints(food_eaten);
+  food_carried_ -= food_eaten;
+}
+
+void Ant::generateRandomNumber(int range) {
+  last_random_number_ = getStudentWorld().randInt(0, range - 1);
 }
 
 int Ant::getImageForColony(int colony) {
@@ -534,22 +489,24 @@ void Ant::bite(Actor *bit_by, int damage) {
 Grasshopper::Grasshopper(StudentWorld &student_world, int iid, Coordinate coord,
                          int points)
     : Insect(student_world, iid, coord, ActorType::GRASSHOPPER,
-             static_cast<Actor::Direction>(randInt(1, 4)), kDepth, points),
-      distance_(randInt(kMinRandomWalkRange, kMaxRandomWalkRange)) {}
+             static_cast<Actor::Direction>(student_world.randInt(1, 4)),
+             kDepth, points),
+      distance_(
+          student_world.randInt(kMinRandomWalkRange, kMaxRandomWalkRange)) {}
 
 void Grasshopper::randomMovement() {
   // Pick a new direction and distance once the last walk finishes.
   if (distance_ <= 0) {
     setDirection(randomDirection());
-    distance_ = randInt(kMinRandomWalkRange, kMaxRandomWalkRange);
+    distance_ =
+        getStudentWorld().randInt(kMinRandomWalkRange, kMaxRandomWalkRange);
   }
 
   Coordinate coord_in_direction = getCoord().coordInDirection(getDirection());
-  std::list<Actor *> pebbles_in_direction =
-      getStudentWorld().actorsOfTypeAt(ActorType::PEBBLE, coord_in_direction);
-
   // Don't walk into pebbles.
-  if (pebbles_in_direction.size() > 0) distance_ = 0;
+  if (getStudentWorld().actorTypesAt(coord_in_direction) &
+      ActorCell::typeBit(ActorType::PEBBLE))
+    distance_ = 0;
 
   if (distance_-- > 0) {
     moveTo(coord_in_direction);
@@ -596,7 +553,8 @@ void BabyGrasshopper::doSomething() {
   }
 
   if (sleep()) return;
-  if (!(eatFood(kMaxGrasshopperFoodPerEating) && randInt(0, 1) == 0))
+  if (!(eatFood(kMaxGrasshopperFoodPerEating) &&
+        getStudentWorld().randInt(0, 1) == 0))
     randomMovement();
 
   addSleep(2);
@@ -629,10 +587,11 @@ void AdultGrasshopper::doSomething() {
 
   // 1/3rd chance that the adult grasshopper bites an enemy at the point, if
   // there is an enemy at the point.
-  if (actors_at_point.size() > 1 && randInt(0, 2) == 0) {  // 1 in 3 chance.
+  if (actors_at_point.size() > 1 &&
+      getStudentWorld().randInt(0, 2) == 0) {  // 1 in 3 chance.
     actors_at_point.remove(this);  // Make sure it does not bite itself.
 
-    int rand_index = randInt(0, actors_at_point.size() - 1);
+    int rand_index = getStudentWorld().randInt(0, actors_at_point.size() - 1);
     std::list<Actor *>::const_iterator i = actors_at_point.begin();
 
     // Iterate until we have a pointer to the randomly selected enemy actor to
@@ -640,7 +599,8 @@ void AdultGrasshopper::doSomething() {
     for (int j = 0; j < rand_index; j++) i++;
 
     (*i)->bite(this, kBiteStrength);
-  } else if (randInt(0, 9) == 0) {  // 1/10th chance it jumps somwhere else
+  } else if (getStudentWorld().randInt(0, 9) == 0) {
+    // 1/10th chance it jumps somwhere else
     Coordinate jump_to_coord(0, 0);
     int give_up = 0;
     bool gave_up = false;
@@ -654,23 +614,26 @@ void AdultGrasshopper::doSomething() {
       }
 
       const int really_big_number = 10e6;
-      int radius = randInt(0, kJumpRadius);
-      double theta = M_PI * randInt(0, really_big_number) / really_big_number;
+      int radius = getStudentWorld().randInt(0, kJumpRadius);
+      double theta = M_PI *
+                     getStudentWorld().randInt(0, really_big_number) /
+                     really_big_number;
 
       jump_to_coord.setX(getX() + radius * cos(theta));
       jump_to_coord.setY(getY() + radius * sin(theta));
     } while (jump_to_coord.getX() < 0 || jump_to_coord.getX() >= VIEW_WIDTH ||
              jump_to_coord.getY() < 0 || jump_to_coord.getY() >= VIEW_HEIGHT ||
-             getStudentWorld()
-                     .actorsOfTypeAt(ActorType::PEBBLE, jump_to_coord)
-                     .size() > 0);  // Keep looking until we have a good coord.
+             // Keep looking until we have a good coord.
+             (getStudentWorld().actorTypesAt(jump_to_coord) &
+              ActorCell::typeBit(ActorType::PEBBLE)) != 0);
 
     // Jump to the coordinate only if a valid one is found.
     if (!gave_up) moveTo(jump_to_coord);
   } else {
     // Attempt to eat. (and have a 50% chance of sleeping if we did sleep)
     // Otherwise, move somewhere.
-    if (!(eatFood(kMaxGrasshopperFoodPerEating) && randInt(0, 1) == 0))
+    if (!(eatFood(kMaxGrasshopperFoodPerEating) &&
+          getStudentWorld().randInt(0, 1) == 0))
       randomMovement();
   }
 
@@ -687,7 +650,7 @@ void AdultGrasshopper::bite(Actor *bit_by, int damage) {
   Insect::bite(bit_by, damage);
 
   // 50% chance of retaliating.
-  if (randInt(0, 1) == 0) {
+  if (getStudentWorld().randInt(0, 1) == 0) {
     bit_by->bite(this, kBiteStrength);
   }
 }
@@ -5,6 +5,7 @@
 #include "StudentWorld.h"
 #include "Compiler.h"
 
+class AntProgram;
 class StudentWorld;
 
 // Actor identifier for use in searching for specific types of actors in the
@@ -132,20 +133,20 @@ class Pheromone : public Actor {
 class AntHill : public Actor {
  public:
   AntHill(StudentWorld &student_world, int colony, Coordinate coord,
-          Compiler *compiler);
+          const AntProgram *program, int population_scale);
   void doSomething();
   static ActorType getActorTypeFromColony(int colony);
 
  private:
   static const int kDepth = 2;
   static const int kInitialHitPoints = 8999;
-  const int kReserveHitPoints = 500;
+  static const int kReserveHitPoints = 500;
   const int kAntHitPoints = 1500;
   const int kMaxFoodConsumptionPerTick = 10000;
   const int kPoisonDamage = 150;
 
   void giveBirth();
-  Compiler *compiler_;
+  const AntProgram *program_;
   int colony_;
 };
 
@@ -177,10 +178,34 @@ class Insect : public Actor {
 class Ant : public Insect {
  public:
   Ant(StudentWorld &student_world, int colony, Coordinate coord,
-      Compiler *compiler, AntHill &my_anthill, int hit_points);
+      const AntProgram *program, AntHill &my_anthill, int hit_points);
   void doSomething();
   void bite(Actor *actor, int damage);
 
+  // Conditions that a bug program can test, as named in Compiler::Condition.
+  bool smellDangerInFront();
+  bool smellPheromoneInFront();
+  bool wasBit() const;
+  bool isCarryingFood() const;
+  bool isHungry() const;
+  bool isStandingOnMyAntHill();
+  bool isStandingOnFood();
+  bool isStandingWithEnemy();
+  bool wasBlockedFromMoving() const;
+  bool lastRandomNumberWasZero() const;
+
+  // Actions that a bug program can take, as named in Compiler::Opcode.
+  void emitPheromone();
+  void faceRandomDirection();
+  void rotateClockwise();
+  void rotateCounterClockwise();
+  void moveForward();
+  void biteEnemy();
+  void pickUpFood();
+  void dropFood();
+  void eatFood();
+  void generateRandomNumber(int range);
+
   // Convert between raw colony number and ant actor type.
   static ActorType getActorTypeFromColony(int colony);
   static int getColonyFromActorType(ActorType actor_type);
@@ -196,16 +221,19 @@ class Ant : public Insect {
 
   // Get image for an ant by the ant's raw colony number.
   static int getImageForColony(int colony);
-  // Run a command and return whether another command should be run.
-  bool runCommand(const Compiler::Command &c);
 
-  Compiler *compiler_;
+  const AntProgram *program_;
   int instruction_counter_;
   bool blocked_by_pebble_;
   int last_random_number_;
   int food_carried_;
   bool was_bit_;
   std::vector<ActorType> other_insects_;
+  // The types that this ant's conditions look for, worked out once, with the
+  // enemy insects as a mask of ActorCell::typeBit.
+  std::uint32_t other_insects_mask_;
+  ActorType pheromone_type_;
+  ActorType ant_hill_type_;
   AntHill &my_ant_hill_;
 };
 
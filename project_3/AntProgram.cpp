@@ -0,0 +1,236 @@
+#include "AntProgram.h"
+
+#include <iostream>
+
+#include "Actor.h"
+
+// Labels as values are a GCC extension, which Clang supports as well.
+#if defined(__GNUC__)
+#define ANT_PROGRAM_THREADED 1
+#else
+#define ANT_PROGRAM_THREADED 0
+#endif
+
+AntProgram::AntProgram(const Compiler &compiler)
+    : fingerprint_(14695981039346656037ULL), native_(nullptr) {
+  int pc = 0, executed = 0;
+  const void *const *handlers;
+  execute<ANT_PROGRAM_THREADED>(nullptr, 0, nullptr, pc, executed, &handlers);
+
+  const std::vector<Compiler::Instruction> &instructions =
+      compiler.getInstructions();
+  steps_.resize(instructions.size());
+  for (int i = 0; i < steps_.size(); i++) {
+    steps_[i].operation = decode(instructions[i]);
+    steps_[i].operand = instructions[i].operand;
+    steps_[i].threaded_operand = instructions[i].threadedOperand;
+    steps_[i].cost = instructions[i].cost;
+    steps_[i].handler =
+        handlers == nullptr ? nullptr : handlers[steps_[i].operation];
+
+    // Hash each field of the instruction, byte by byte, with 64-bit FNV-1a.
+    std::uint32_t fields[5] = {
+        instructions[i].opcode, instructions[i].condition,
+        instructions[i].cost,
+        static_cast<std::uint32_t>(instructions[i].operand),
+        static_cast<std::uint32_t>(instructions[i].threadedOperand)};
+    for (int field = 0; field < 5; field++) {
+      for (int byte = 0; byte < 4; byte++) {
+        fingerprint_ ^= (fields[field] >> (8 * byte)) & 0xff;
+        fingerprint_ *= 1099511628211ULL;
+      }
+    }
+  }
+}
+
+int AntProgram::size() const { return steps_.size(); }
+
+std::uint64_t AntProgram::fingerprint() const { return fingerprint_; }
+
+void AntProgram::setNative(NativeFunction native) { native_ = native; }
+
+bool AntProgram::isNative() const { return native_ != nullptr; }
+
+bool AntProgram::run(Ant &ant, int &pc, int &executed) const {
+  if (native_ != nullptr) return native_(ant, pc, executed);
+  return execute<ANT_PROGRAM_THREADED>(steps_.data(), steps_.size(), &ant, pc,
+                                       executed, nullptr);
+}
+
+bool AntProgram::runSwitch(Ant &ant, int &pc, int &executed) const {
+  return execute<false>(steps_.data(), steps_.size(), &ant, pc, executed,
+                        nullptr);
+}
+
+AntProgram::Operation AntProgram::decode(
+    const Compiler::Instruction &instruction) {
+  switch (instruction.opcode) {
+    case Compiler::goto_command:
+      return kGoto;
+    case Compiler::if_command:
+      // The conditions are numbered in the same order as the if operations.
+      if (instruction.condition > Compiler::last_random_number_was_zero)
+        return kInvalid;
+      return static_cast<Operation>(kIfSmellDangerInFront +
+                                    instruction.condition);
+    case Compiler::emitPheromone:
+      return kEmitPheromone;
+    case Compiler::faceRandomDirection:
+      return kFaceRandomDirection;
+    case Compiler::rotateClockwise:
+      return kRotateClockwise;
+    case Compiler::rotateCounterClockwise:
+      return kRotateCounterClockwise;
+    case Compiler::moveForward:
+      return kMoveForward;
+    case Compiler::bite:
+      return kBite;
+    case Compiler::pickupFood:
+      return kPickUpFood;
+    case Compiler::dropFood:
+      return kDropFood;
+    case Compiler::eatFood:
+      return kEatFood;
+    case Compiler::generateRandomNumber:
+      return kGenerateRandomNumber;
+    default:
+      return kInvalid;
+  }
+}
+
+// Go to the code for the current step, directly when threaded and otherwise
+// through the switch.
+#if ANT_PROGRAM_THREADED
+#define DISPATCH()                       \
+  do {                                   \
+    if (kThreaded) goto *step->handler;  \
+    goto dispatch;                       \
+  } while (0)
+#else
+#define DISPATCH() goto dispatch
+#endif
+
+// Fetch the next step and run it, unless the tick's budget of instructions
+// has been used up.
+#define NEXT()                                          \
+  do {                                                  \
+    if (charged == kInstructionsPerTick) return true;   \
+    if (pc < 0 || pc >= size) return false;             \
+    step = &steps[pc++];                                \
+    executed++;                                         \
+    charged++;                                          \
+    DISPATCH();                                         \
+  } while (0)
+
+// Take the jump of a goto or if, threaded past the gotos it leads to when
+// enough of the budget is left to have run all of them. The budget is
+// charged for the gotos skipped, though they are not run.
+#define JUMP()                                                \
+  do {                                                        \
+    if (charged + step->cost - 1 <= kInstructionsPerTick) {   \
+      charged += step->cost - 1;                              \
+      pc = step->threaded_operand;                            \
+    } else {                                                  \
+      pc = step->operand;                                     \
+    }                                                         \
+  } while (0)
+
+#define CONDITION(operation, test)  \
+  case operation:                   \
+  operation##_label:                \
+    if (ant->test()) JUMP();        \
+    NEXT()
+
+#define ACTION(operation, action)  \
+  case operation:                  \
+  operation##_label:               \
+    ant->action;                   \
+    return true
+
+template <bool kThreaded>
+bool AntProgram::execute(const Step *steps, int size, Ant *ant, int &pc,
+                         int &executed, const void *const **handlers) {
+#if ANT_PROGRAM_THREADED
+  static const void *const kHandlers[kNumOperations] = {
+      &&kGoto_label,
+      &&kIfSmellDangerInFront_label,
+      &&kIfSmellPheromoneInFront_label,
+      &&kIfWasBit_label,
+      &&kIfCarryingFood_label,
+      &&kIfHungry_label,
+      &&kIfStandingOnMyAntHill_label,
+      &&kIfStandingOnFood_label,
+      &&kIfStandingWithEnemy_label,
+      &&kIfWasBlockedFromMoving_label,
+      &&kIfLastRandomNumberWasZero_label,
+      &&kEmitPheromone_label,
+      &&kFaceRandomDirection_label,
+      &&kRotateClockwise_label,
+      &&kRotateCounterClockwise_label,
+      &&kMoveForward_label,
+      &&kBite_label,
+      &&kPickUpFood_label,
+      &&kDropFood_label,
+      &&kEatFood_label,
+      &&kGenerateRandomNumber_label,
+      &&kInvalid_label,
+  };
+  if (steps == nullptr) {
+    *handlers = kThreaded ? kHandlers : nullptr;
+    return true;
+  }
+#else
+  if (steps == nullptr) {
+    *handlers = nullptr;
+    return true;
+  }
+#endif
+
+  const Step *step;
+  int charged = 0;  // Instructions charged to the budget.
+  executed = 0;
+  NEXT();
+
+dispatch:
+  switch (step->operation) {
+    case kGoto:
+    kGoto_label:
+      JUMP();
+      NEXT();
+
+      CONDITION(kIfSmellDangerInFront, smellDangerInFront);
+      CONDITION(kIfSmellPheromoneInFront, smellPheromoneInFront);
+      CONDITION(kIfWasBit, wasBit);
+      CONDITION(kIfCarryingFood, isCarryingFood);
+      CONDITION(kIfHungry, isHungry);
+      CONDITION(kIfStandingOnMyAntHill, isStandingOnMyAntHill);
+      CONDITION(kIfStandingOnFood, isStandingOnFood);
+      CONDITION(kIfStandingWithEnemy, isStandingWithEnemy);
+      CONDITION(kIfWasBlockedFromMoving, wasBlockedFromMoving);
+      CONDITION(kIfLastRandomNumberWasZero, lastRandomNumberWasZero);
+
+      ACTION(kEmitPheromone, emitPheromone());
+      ACTION(kFaceRandomDirection, faceRandomDirection());
+      ACTION(kRotateClockwise, rotateClockwise());
+      ACTION(kRotateCounterClockwise, rotateCounterClockwise());
+      ACTION(kMoveForward, moveForward());
+      ACTION(kBite, biteEnemy());
+      ACTION(kPickUpFood, pickUpFood());
+      ACTION(kDropFood, dropFood());
+      ACTION(kEatFood, eatFood());
+      ACTION(kGenerateRandomNumber, generateRandomNumber(step->operand));
+
+    case kInvalid:
+    default:
+    kInvalid_label:
+      std::cerr << "INVALID COMMAND" << std::endl;
+      ant->die();
+      return true;
+  }
+}
+
+#undef ACTION
+#undef CONDITION
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
@@ -0,0 +1,116 @@
+#ifndef ANTPROGRAM_H_
+#define ANTPROGRAM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Compiler.h"
+#include "GameConstants.h"
+
+class Ant;
+
+// A compiled bug program, decoded once per colony into the form that ants run
+// it in. Every instruction is turned into a step whose operation says exactly
+// what to do, with each kind of if split into its own operation by the
+// condition it tests, so that running a step takes a single dispatch.
+//
+// Where the compiler supports taking the address of a label (GCC and Clang),
+// each step also holds the address of the code that runs it, and run jumps
+// straight from one step to the next without going back through a switch.
+// runSwitch runs the same steps through a switch, and is what run does on
+// other compilers.
+//
+// A program can also be translated ahead of time into a C++ function by
+// BugsTranslate, and then run as native code instead of being interpreted.
+class AntProgram {
+ public:
+  // Most instructions an ant runs in one tick. Taking an action also ends the
+  // tick, while goto and if do not.
+  static const int kInstructionsPerTick = MAX_INSTRUCTIONS_PER_TICK;
+
+  // A program translated to C++, which runs a tick exactly as run does.
+  typedef bool (*NativeFunction)(Ant &ant, int &pc, int &executed);
+
+  struct NativeProgram {
+    const char *colony_name;
+    std::uint64_t fingerprint;  // Of the program it was translated from.
+    NativeFunction run;
+  };
+
+  explicit AntProgram(const Compiler &compiler);
+
+  int size() const;
+  // Hash of the decoded instructions, which tells a translation of this
+  // program apart from translations of other programs or of older versions
+  // of it.
+  std::uint64_t fingerprint() const;
+
+  // Run ticks with a translation of this program from now on, or go back to
+  // interpreting it when given nullptr.
+  void setNative(NativeFunction native);
+  bool isNative() const;
+
+  // Run one tick of the program for an ant, starting from instruction pc,
+  // and leave pc at the instruction to run next tick. executed is set to the
+  // number of instructions run, which for an optimized program can be fewer
+  // than were charged to the tick's budget. Returns false if the ant reached
+  // an instruction outside of the program, which should kill it.
+  bool run(Ant &ant, int &pc, int &executed) const;
+  bool runSwitch(Ant &ant, int &pc, int &executed) const;
+
+  // We prevent an AntProgram object from being copied or assigned.
+  AntProgram(const AntProgram &) = delete;
+  AntProgram &operator=(const AntProgram &) = delete;
+
+ private:
+  enum Operation : std::uint8_t {
+    kGoto,
+    kIfSmellDangerInFront,
+    kIfSmellPheromoneInFront,
+    kIfWasBit,
+    kIfCarryingFood,
+    kIfHungry,
+    kIfStandingOnMyAntHill,
+    kIfStandingOnFood,
+    kIfStandingWithEnemy,
+    kIfWasBlockedFromMoving,
+    kIfLastRandomNumberWasZero,
+    kEmitPheromone,
+    kFaceRandomDirection,
+    kRotateClockwise,
+    kRotateCounterClockwise,
+    kMoveForward,
+    kBite,
+    kPickUpFood,
+    kDropFood,
+    kEatFood,
+    kGenerateRandomNumber,
+    kInvalid,
+    kNumOperations
+  };
+
+  struct Step {
+    const void *handler;  // Code that runs the step, when threaded.
+    std::int32_t operand;  // Target of goto and if, or the random range.
+    // Target of goto and if past the gotos that operand leads to, and the
+    // instructions that jumping to it costs (see Compiler::optimize).
+    std::int32_t threaded_operand;
+    std::uint8_t cost;
+    Operation operation;
+  };
+
+  static Operation decode(const Compiler::Instruction &instruction);
+
+  // Shared by run and runSwitch. Called with no steps, it only sets handlers
+  // to the table of code addresses indexed by Operation, or to nullptr if
+  // there is none.
+  template <bool kThreaded>
+  static bool execute(const Step *steps, int size, Ant *ant, int &pc,
+                      int &executed, const void *const **handlers);
+
+  std::vector<Step> steps_;
+  std::uint64_t fingerprint_;
+  NativeFunction native_;
+};
+
+#endif  // ANTPROGRAM_H_
@@ -8,6 +8,7 @@
 #include <map>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 
 #include "GameConstants.h"
 
@@ -56,6 +57,29 @@ public:
 		int lineNum;
 	};
 
+	// A command decoded for running: labels are resolved to instruction
+	// numbers and numbers are parsed, so that an ant never looks at text.
+	// The command that each instruction came from stays available through
+	// getCommand, for debugging.
+	//
+	// Each tick, an ant runs at most MAX_INSTRUCTIONS_PER_TICK instructions.
+	// goto_command and if_command count as one each and go on to the next
+	// instruction, while every other command counts as one and ends the tick.
+	// The ant goes on from the same instruction the next tick, and it dies
+	// when it goes to run an instruction outside of the program while it
+	// still has some of the tick's budget left.
+	struct Instruction
+	{
+		std::uint8_t opcode;	// An Opcode.
+		std::uint8_t condition;	// A Condition, for if_command only.
+		std::uint8_t cost;		// Instructions that the jump to
+								// threadedOperand stands for (see optimize).
+		std::int32_t operand;	// The target of goto_command and if_command,
+								// and the range of generateRandomNumber.
+		std::int32_t threadedOperand;	// operand, or a target further along
+										// the gotos that operand leads to.
+	};
+
 	Compiler()
 	{
 		m_colonyName = "--------";
@@ -67,6 +91,7 @@ public:
 	{
 		m_labelToLine.clear();
 		m_outputProgram.clear();
+		m_instructions.clear();
 
 		std::ifstream inf;
 		for (auto suffix : { "", ".bug", ".txt", ".bug.txt" })
@@ -161,9 +186,85 @@ public:
 			}
 		}
 
+		// decode every command, now that all of its operands are numbers
+
+		for (size_t i = 0; i < m_outputProgram.size(); ++i)
+		{
+			const Command& c = m_outputProgram[i];
+			Instruction instruction;
+			instruction.opcode = static_cast<std::uint8_t>(c.opcode);
+			instruction.condition = 0;
+			instruction.operand = 0;
+			if (c.opcode == if_command)
+			{
+				instruction.condition = static_cast<std::uint8_t>(std::stoi(c.operand1));
+				instruction.operand = std::stoi(c.operand2);
+			}
+			else if (c.opcode == goto_command  ||  c.opcode == generateRandomNumber)
+				instruction.operand = std::stoi(c.operand1);
+			instruction.cost = 1;
+			instruction.threadedOperand = instruction.operand;
+			m_instructions.push_back(instruction);
+		}
+
 		return true;
 	}
 
+	// The compiled program, to be run from instruction 0.
+	const std::vector<Instruction>& getInstructions() const
+	{
+		return m_instructions;
+	}
+
+	// Optimize the compiled program, without changing what an ant running it
+	// does in any tick or how many instructions it runs:
+	//  - instructions that no ant can reach are removed,
+	//  - an if that goes to the next instruction either way becomes a goto,
+	//    which does not test its condition, and
+	//  - the target of every goto and if is threaded past the gotos that
+	//    it leads to, up to a tick's worth of them.
+	// A threaded jump stands for cost instructions, the jump itself and the
+	// gotos it skips, so that the ant is charged for all of them. It is only
+	// taken when that many are left of the tick's budget. Otherwise the ant
+	// jumps to operand as written, and runs out of budget on one of the
+	// gotos in between, just as it would have without optimizing.
+	void optimize()
+	{
+		removeUnreachableInstructions();
+
+		for (size_t i = 0; i < m_instructions.size(); ++i)
+		{
+			Instruction& instruction = m_instructions[i];
+			if (instruction.opcode == if_command  &&  instruction.operand == static_cast<int>(i) + 1)
+			{
+				instruction.opcode = goto_command;
+				instruction.condition = 0;
+			}
+		}
+
+		for (size_t i = 0; i < m_instructions.size(); ++i)
+		{
+			Instruction& instruction = m_instructions[i];
+			if (instruction.opcode != goto_command  &&  instruction.opcode != if_command)
+				continue;
+
+			// Follow the gotos from the target while the ant could run all of
+			// them in one tick. The chain may loop back on itself, which the
+			// budget ends like any other.
+			int target = instruction.operand;
+			int cost = 1;
+			while (cost < MAX_INSTRUCTIONS_PER_TICK  &&  target >= 0  &&
+				   target < static_cast<int>(m_instructions.size())  &&
+				   m_instructions[target].opcode == goto_command)
+			{
+				target = m_instructions[target].operand;
+				cost++;
+			}
+			instruction.cost = static_cast<std::uint8_t>(cost);
+			instruction.threadedOperand = target;
+		}
+	}
+
 	bool getCommand(int lineNumber, Command& c) const
 	{
 		if (lineNumber < 0  ||  lineNumber >= static_cast<int>(m_outputProgram.size()))
@@ -179,6 +280,56 @@ private:
 		empty_line, valid_line, error_line
 	};
 
+	// Remove the instructions that cannot be reached from the first one, and
+	// renumber the targets of the rest. Targets past the end of the program
+	// stay past its end.
+	void removeUnreachableInstructions()
+	{
+		int size = m_instructions.size();
+		std::vector<bool> reachable(size, false);
+		std::vector<int> toVisit(1, 0);
+		while ( ! toVisit.empty())
+		{
+			int i = toVisit.back();
+			toVisit.pop_back();
+			if (i < 0  ||  i >= size  ||  reachable[i])
+				continue;
+			reachable[i] = true;
+
+			const Instruction& instruction = m_instructions[i];
+			if (instruction.opcode == goto_command  ||  instruction.opcode == if_command)
+				toVisit.push_back(instruction.operand);
+			if (instruction.opcode != goto_command)
+				toVisit.push_back(i + 1);
+		}
+
+		std::vector<int> newNumber(size + 1);
+		int kept = 0;
+		for (int i = 0; i < size; i++)
+		{
+			newNumber[i] = kept;
+			if (reachable[i])
+			{
+				m_instructions[kept] = m_instructions[i];
+				m_outputProgram[kept] = m_outputProgram[i];
+				kept++;
+			}
+		}
+		newNumber[size] = kept;
+		m_instructions.resize(kept);
+		m_outputProgram.resize(kept);
+
+		for (size_t i = 0; i < m_instructions.size(); ++i)
+		{
+			Instruction& instruction = m_instructions[i];
+			if (instruction.opcode != goto_command  &&  instruction.opcode != if_command)
+				continue;
+			int target = instruction.operand;
+			instruction.operand = (target >= 0  &&  target < size ? newNumber[target] : target - size + kept);
+			instruction.threadedOperand = instruction.operand;
+		}
+	}
+
 	ParseResult parseLine(std::string line, Command& c, int lineNum, std::string& firstError)
 	{
 		c.lineNum = lineNum;
@@ -385,7 +536,8 @@ private:
 private:
 	static const int				MIN_TOKENS_PER_LINE = 1;
 	std::map<std::string, size_t>	m_labelToLine;
-	std::vector<Command>			m_outputProgram;
+	std::vector<Command>			m_outputProgram;	// source of each instruction
+	std::vector<Instruction>		m_instructions;
 	std::string						m_colonyName;
 };
 
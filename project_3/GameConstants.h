@@ -42,6 +42,10 @@ const int KEY_PRESS_TAB = '\t';
 
 const int NUM_ANT_MEMORY_CELLS = 3;
 
+// most bug program instructions an ant runs in one tick
+
+const int MAX_INSTRUCTIONS_PER_TICK = 10;
+
 // # ant colonies
 
 const int MAX_ANT_COLONIES = 4;
@@ -73,11 +77,14 @@ const int GWSTATUS_LEVEL_ERROR = 3;
 
 const int NUM_TEST_PARAMS = 1;
 
-// Return a uniformly distributed random int from min to max, inclusive
+// Return a uniformly distributed random int from min to max, inclusive.
+// Each thread draws from its own generator. Actors draw from their world's
+// generator instead (see StudentWorld::randInt), so that games can be
+// replayed.
 inline int randInt(int min, int max) {
   if (max < min) std::swap(max, min);
-  static std::random_device rd;
-  static std::mt19937 generator(rd());
+  static thread_local std::random_device rd;
+  static thread_local std::mt19937 generator(rd());
   std::uniform_int_distribution<> distro(min, max);
   return distro(generator);
 }
@@ -0,0 +1,20 @@
+#include "GameWorld.h"
+#include <string>
+using namespace std;
+
+// Stand-in for GameWorld.cpp in programs that run the simulation without a
+// GameController to draw it, so that they build without OpenGL. Nothing is
+// shown or played, and no key is ever pressed.
+
+bool GameWorld::getKey(int& value)
+{
+	return false;
+}
+
+void GameWorld::playSound(int soundID)
+{
+}
+
+void GameWorld::setGameStatText(string text)
+{
+}
@@ -1,7 +1,6 @@
 #ifndef GRAPHOBJ_H_
 #define GRAPHOBJ_H_
 
-#include "SpriteManager.h"
 #include "GameConstants.h"
 
 #include <set>
@@ -95,8 +94,11 @@ class GraphObject {
     moveALittle(m_y, m_destY);
   }
 
+  // The objects of the world being played on the calling thread, for
+  // drawing. Each thread keeps its own, so that worlds can be played on
+  // several threads at once.
   static std::set<GraphObject *> &getGraphObjects(unsigned int layer) {
-    static std::set<GraphObject *> graphObjects[NUM_LAYERS];
+    static thread_local std::set<GraphObject *> graphObjects[NUM_LAYERS];
     if (layer < NUM_LAYERS)
       return graphObjects[layer];
     else
@@ -0,0 +1,11 @@
+#ifndef NATIVEPROGRAMS_H_
+#define NATIVEPROGRAMS_H_
+
+#include "AntProgram.h"
+
+// Bug programs translated ahead of time to C++, which BugsTranslate generates
+// as NativePrograms.cpp from the bundled colonies (see the Makefile).
+extern const AntProgram::NativeProgram kNativePrograms[];
+extern const int kNumNativePrograms;
+
+#endif  // NATIVEPROGRAMS_H_
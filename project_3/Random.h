@@ -0,0 +1,70 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+
+// Pseudorandom number generator owned by a single world, so that a world
+// given the same seed plays the same game, and worlds on different threads
+// draw from generators of their own. This is xoshiro256**, seeded through
+// splitmix64 so that any seed, even 0, gives a well-mixed state.
+class Random {
+ public:
+  explicit Random(std::uint64_t seed = 0) { setSeed(seed); }
+
+  void setSeed(std::uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      state_[i] = z ^ (z >> 31);
+    }
+  }
+
+  std::uint64_t next() {
+    std::uint64_t result = rotateLeft(state_[1] * 5, 7) * 9;
+    std::uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotateLeft(state_[3], 45);
+    return result;
+  }
+
+  // Return a uniformly distributed random int from min to max, inclusive,
+  // as randInt does. The bound is applied with Lemire's multiply-and-shift
+  // method, which rejects just enough draws to leave no bias.
+  int randInt(int min, int max) {
+    if (max < min) {
+      int swap = min;
+      min = max;
+      max = swap;
+    }
+    std::uint32_t range = static_cast<std::uint32_t>(max) -
+                          static_cast<std::uint32_t>(min) + 1;
+    if (range == 0) return static_cast<int>(next() >> 32);  // Every int.
+
+    std::uint64_t product = (next() >> 32) * range;
+    std::uint32_t low = static_cast<std::uint32_t>(product);
+    if (low < range) {
+      std::uint32_t threshold = -range % range;
+      while (low < threshold) {
+        product = (next() >> 32) * range;
+        low = static_cast<std::uint32_t>(product);
+      }
+    }
+    return static_cast<int>(static_cast<std::uint32_t>(min) +
+                            static_cast<std::uint32_t>(product >> 32));
+  }
+
+ private:
+  static std::uint64_t rotateLeft(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  std::uint64_t state_[4];
+};
+
+#endif  // RANDOM_H_
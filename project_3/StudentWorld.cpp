@@ -1,6 +1,7 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <random>
 
 #include "Actor.h"
 #include "StudentWorld.h"
@@ -46,21 +47,102 @@ Coordinate Coordinate::coordInDirection(GraphObject::Direction direction) {
   return Coordinate(x, y);
 }
 
+static_assert(static_cast<int>(ActorType::ANT_HILL3) + 1 ==
+                  ActorCell::kNumActorTypes,
+              "ActorCell must count every type of actor");
+
+ActorCell::ActorCell() : size_(0) { clear(); }
+uint32_t ActorCell::typeBit(ActorType type) {
+  return uint32_t(1) << static_cast<int>(type);
+}
+int ActorCell::size() const { return size_; }
+Actor *ActorCell::operator[](int i) const {
+  return i < kInlineActors ? inline_[i] : overflow_[i - kInlineActors];
+}
+Actor *&ActorCell::slot(int i) {
+  return i < kInlineActors ? inline_[i] : overflow_[i - kInlineActors];
+}
+void ActorCell::push_back(Actor *actor) {
+  if (size_ < kInlineActors) {
+    inline_[size_] = actor;
+  } else if (size_ - kInlineActors < static_cast<int>(overflow_.size())) {
+    // Reuse a slot left over from when the cell held more actors.
+    overflow_[size_ - kInlineActors] = actor;
+  } else {
+    overflow_.push_back(actor);
+  }
+  size_++;
+  count(actor, 1);
+}
+void ActorCell::remove(int i) {
+  count(slot(i), -1);
+  slot(i) = nullptr;
+}
+void ActorCell::removeNulls() {
+  int kept = 0;
+  for (int i = 0; i < size_; i++) {
+    if (slot(i) != nullptr) slot(kept++) = slot(i);
+  }
+  size_ = kept;
+}
+void ActorCell::clear() {
+  size_ = 0;
+  for (int i = 0; i < kNumActorTypes; i++) type_counts_[i] = 0;
+  types_ = 0;
+}
+uint32_t ActorCell::types() const { return types_; }
+Actor *ActorCell::firstOfType(ActorType type) const {
+  if ((types_ & typeBit(type)) == 0) return nullptr;
+  for (int i = 0; i < size_; i++) {
+    Actor *actor = (*this)[i];
+    if (actor != nullptr && actor->checkForObjectMatch(type)) return actor;
+  }
+  return nullptr;
+}
+void ActorCell::count(Actor *actor, int delta) {
+  int type = static_cast<int>(actor->getActorType());
+  type_counts_[type] += delta;
+  if (type_counts_[type] > 0) {
+    types_ |= typeBit(actor->getActorType());
+  } else {
+    types_ &= ~typeBit(actor->getActorType());
+  }
+}
+
 StudentWorld::StudentWorld(std::string assetDir)
     : GameWorld(assetDir),
       ticks_(0),
+      instructions_run_(0),
+      ant_ticks_run_(0),
+      optimize_programs_(false),
+      population_scale_(1),
       leader_(-1),
       scoreboard_{0, 0, 0, 0},
-      ant_hills_on_field_(0) {}
+      programs_{nullptr, nullptr, nullptr, nullptr},
+      native_programs_(nullptr),
+      num_native_programs_(0),
+      seed_(0),
+      has_seed_(false),
+      ant_hills_on_field_(0) {
+  for (int i = 0; i < (kNumCells + 63) / 64; i++) cells_to_visit_[i] = 0;
+}
 
 StudentWorld::~StudentWorld() {
   for(int i = 0;i < 4;i++) {
-    if(compilers_[i] == nullptr) continue;
-    delete compilers_[i];
+    if(programs_[i] == nullptr) continue;
+    delete programs_[i];
   }
 }
 
 int StudentWorld::init() {
+  // Start the random numbers over, so that a seeded game can be replayed.
+  if (has_seed_) {
+    random_.setSeed(seed_);
+  } else {
+    random_device device;
+    random_.setSeed((static_cast<uint64_t>(device()) << 32) | device());
+  }
+
   // Load the field.
   Field f;
   string fieldFile = getFieldFilename(), error;
@@ -75,22 +157,29 @@ int StudentWorld::init() {
   // Cap maximum number of bugs allowed on the field to four.
   if (ant_hills_on_field_ > 4) return GWSTATUS_LEVEL_ERROR;
 
-  // Create compilers for bugs.
+  // Compile the bugs, and decode each of their programs for the ants to run.
   for(int i = 0;i < 4;i++) {
     // Default nullptr in case compiler is not found.
-    compilers_[i] = nullptr;
+    delete programs_[i];
+    programs_[i] = nullptr;
   }
   for (int i = 0; i < file_names.size(); i++) {
-    compilers_[i] = new Compiler();
+    Compiler compiler;
 
     // Check for success in interpreting the code, and die on any errors.
-    if (!compilers_[i]->compile(file_names[i], error)) {
+    if (!compiler.compile(file_names[i], error)) {
       setError(file_names[i] + " " + error);
       return GWSTATUS_LEVEL_ERROR;
     }
+    if (optimize_programs_) compiler.optimize();
+    programs_[i] = new AntProgram(compiler);
+    for (int j = 0; j < num_native_programs_; j++) {
+      if (native_programs_[j].fingerprint == programs_[i]->fingerprint())
+        programs_[i]->setNative(native_programs_[j].run);
+    }
 
     // Store the name to be displayed on the scoreboard.
-    scoreboard_names_[i] = compilers_[i]->getColonyName();
+    scoreboard_names_[i] = compiler.getColonyName();
   }
 
   // Iterate through every single square on the grid of the field in the file
@@ -117,17 +206,13 @@ int StudentWorld::init() {
                  item == Field::FieldItem::anthill2 ||
                  item == Field::FieldItem::anthill3) {
         // Map field items for anthill to their raw colony numbers, for use in
-        // initialization of the anthills.
-        int colony = 0;
-        map<Field::FieldItem, int> field_item_anthill_to_colony;
-        field_item_anthill_to_colony[Field::FieldItem::anthill0] = 0;
-        field_item_anthill_to_colony[Field::FieldItem::anthill1] = 1;
-        field_item_anthill_to_colony[Field::FieldItem::anthill2] = 2;
-        field_item_anthill_to_colony[Field::FieldItem::anthill3] = 3;
-        if(field_item_anthill_to_colony[item] >= ant_hills_on_field_) continue;
-
-        addActor(new AntHill(*this, field_item_anthill_to_colony[item], coord,
-                             compilers_[colony]));
+        // initialization of the anthills. The anthill items are listed in
+        // order of colony.
+        int colony = item - Field::FieldItem::anthill0;
+        if (colony >= ant_hills_on_field_) continue;
+
+        addActor(new AntHill(*this, colony, coord, programs_[colony],
+                             population_scale_));
       }
     }
   }
@@ -138,49 +223,49 @@ int StudentWorld::init() {
 void StudentWorld::cleanUp() {
   ticks_ = 0;
 
-  // Go through every key in the map and delete all objects within their
-  // respective
-  // lists.
-  for (std::map<Coordinate, std::list<Actor *>>::iterator i = actors_.begin();
-       i != actors_.end(); i++) {
-    for (std::list<Actor *>::iterator j = i->second.begin();
-         j != i->second.end(); j++) {
-      if(*j == nullptr) continue;
-      delete *j;
+  // Go through every cell of the grid and delete all objects within them.
+  for (int i = 0; i < VIEW_WIDTH * VIEW_HEIGHT; i++) {
+    for (int j = 0; j < cells_[i].size(); j++) {
+      if (cells_[i][j] == nullptr) continue;
+      delete cells_[i][j];
     }
+    cells_[i].clear();
   }
-
-  actors_.clear();
+  for (int i = 0; i < (kNumCells + 63) / 64; i++) cells_to_visit_[i] = 0;
 }
 
 int StudentWorld::move() {
   updateGameStatText();
 
-  // Iterate through every key in the map, where there are actors existing at
-  // a coordinate.
-  for (std::map<Coordinate, std::list<Actor *>>::iterator i = actors_.begin();
-       i != actors_.end(); i++) {
+  // Iterate through every cell of the grid that has something to do, in the
+  // same order as the coordinates compare, so that actors that move into a
+  // cell that is yet to be visited act again this tick.
+  for (int i = nextCellToVisit(0); i < kNumCells; i = nextCellToVisit(i + 1)) {
+    ActorCell &cell = cells_[i];
+    cells_to_visit_[i / 64] &= ~(uint64_t(1) << (i % 64));
+
     // Garbage collect all nullptrs remaining from deleted objects.
-    i->second.remove(nullptr);
+    cell.removeNulls();
 
-    // Iterate through all items in the list, using the original size to avoid
-    // issues where objects are deleted while iterating through the list.
-    int original_size = i->second.size(), k = 0;
-    for (std::list<Actor *>::iterator j = i->second.begin(); k < original_size;
-         j++, k++) {
-      if (*j == nullptr) continue;  // Ensure that actor was not deleted.
+    // Iterate through all items in the cell, using the original size to avoid
+    // acting for actors that are added to it while iterating.
+    int original_size = cell.size();
+    for (int k = 0; k < original_size; k++) {
+      Actor *actor = cell[k];
+      if (actor == nullptr) continue;  // Ensure that actor was not deleted.
 
-      if (!(*j)->dead()) {
-        (*j)->doSomething();
+      if (!actor->dead()) {
+        actor->doSomething();
       } else {
         // Delete all dead actors.
-        delete *j;
-        *j = nullptr;
+        cell.remove(k);
+        delete actor;
+        markCellToVisit(&cell);
       }
     }
 
-    // Remove keys where there are no actors at a given coordinate.
-    if (i->second.size() < 1) actors_.erase(i);
+    // Come back next tick while the cell holds actors that act.
+    if ((cell.types() & ~idleActorTypes()) != 0) markCellToVisit(&cell);
   }
 
   // End game after 2000 ticks.
@@ -200,9 +285,7 @@ int StudentWorld::move() {
 
 void StudentWorld::addFood(Coordinate coord, int food_points) {
   // Attempt to find a food actor that already exists at the coordinate.
-  Actor *food_actor = nullptr;
-  std::list<Actor *> food_at_point = actorsOfTypeAt(ActorType::FOOD, coord);
-  if (food_at_point.size() > 0) food_actor = *food_at_point.begin();
+  Actor *food_actor = actorOfTypeAt(ActorType::FOOD, coord);
 
   if (food_actor == nullptr) {
     // Create a new food object if no food already exists at the coordinate.
@@ -217,12 +300,8 @@ void StudentWorld::addFood(Coordinate coord, int food_points) {
 void StudentWorld::addPheromone(Coordinate coord, int pheromone_points,
                                 int colony) {
   // Attempt to find a pheromone actor that already exists at the coordinate.
-  Actor *pheromone_actor = nullptr;
-  std::list<Actor *> pheromone_at_point =
-      actorsOfTypeAt(Pheromone::getActorType(colony), coord);
-
-  if (pheromone_at_point.size() > 0)
-    pheromone_actor = *pheromone_at_point.begin();
+  Actor *pheromone_actor =
+      actorOfTypeAt(Pheromone::getActorType(colony), coord);
 
   if (pheromone_actor == nullptr) {
     // Create a new pheromone object if no food already exists at the
@@ -273,20 +352,34 @@ std::list<Actor *> StudentWorld::actorsOfTypeAt(ActorType actor_type,
   // coordinate.
   std::list<Actor *> actors_of_type;
 
-  // List of all actors at the coordinate.
-  std::list<Actor *> actors_at_point = actors_[coord];
-  for (std::list<Actor *>::const_iterator i = actors_at_point.begin();
-       i != actors_at_point.end(); i++) {
-    if (*i == nullptr) continue;  // Ignore deleted actors.
+  // Coordinates off the field hold nothing.
+  ActorCell *cell = cellAt(coord);
+  if (cell == nullptr) return actors_of_type;
+  if ((cell->types() & ActorCell::typeBit(actor_type)) == 0)
+    return actors_of_type;
+
+  for (int i = 0; i < cell->size(); i++) {
+    Actor *actor = (*cell)[i];
+    if (actor == nullptr) continue;  // Ignore deleted actors.
 
     // If the actor is of the type given in the parameter, add it to the return
     // list.
-    if ((*i)->checkForObjectMatch(actor_type)) actors_of_type.push_back(*i);
+    if (actor->checkForObjectMatch(actor_type)) actors_of_type.push_back(actor);
   }
 
   return actors_of_type;
 }
 
+Actor *StudentWorld::actorOfTypeAt(ActorType actor_type, Coordinate coord) {
+  ActorCell *cell = cellAt(coord);
+  return cell == nullptr ? nullptr : cell->firstOfType(actor_type);
+}
+
+uint32_t StudentWorld::actorTypesAt(Coordinate coord) {
+  ActorCell *cell = cellAt(coord);
+  return cell == nullptr ? 0 : cell->types();
+}
+
 std::list<Actor *> StudentWorld::actorsOfTypesAt(
     std::vector<ActorType> actor_types, Coordinate coord) {
   std::list<Actor *> actors_of_types;
@@ -306,13 +399,16 @@ std::list<Actor *> StudentWorld::actorsOfTypesAt(
 }
 
 void StudentWorld::updatePositionInGrid(Actor *actor, Coordinate to_coord) {
-  Coordinate from_coord = actor->getCoord();
-
   // Replace the pointer at the old coordinate for the actor with a nullptr,
-  // which will be garbage collected (removed from this list) by the next tick.
-  std::list<Actor *>::iterator i =
-      std::find(actors_[from_coord].begin(), actors_[from_coord].end(), actor);
-  (*i) = nullptr;
+  // which will be garbage collected (removed from the cell) by the next tick.
+  ActorCell &from_cell = *cellAt(actor->getCoord());
+  for (int i = 0; i < from_cell.size(); i++) {
+    if (from_cell[i] == actor) {
+      from_cell.remove(i);
+      break;
+    }
+  }
+  markCellToVisit(&from_cell);
 
   // Update internal x and y values for the actor, and re-add actor to grid
   // with the new coordinates.
@@ -320,22 +416,93 @@ void StudentWorld::updatePositionInGrid(Actor *actor, Coordinate to_coord) {
   addActor(actor);
 }
 
+void StudentWorld::updateDeathInGrid(Actor *actor) {
+  markCellToVisit(cellAt(actor->getCoord()));
+}
+
 void StudentWorld::addActor(Actor *actor) {
-  // Grab the map element for the coordinate that the actor will be added to.
-  std::map<Coordinate, std::list<Actor *>>::iterator i;
-  i = actors_.find(actor->getCoord());
+  // Actors are only ever placed on the field, so the cell always exists.
+  ActorCell *cell = cellAt(actor->getCoord());
+  cell->push_back(actor);
+  markCellToVisit(cell);
+}
 
-  // If coordinate key exists, add actor to the list for that coordinate.
-  if (i != actors_.end()) {
-    i->second.push_back(actor);
-    return;
+ActorCell *StudentWorld::cellAt(Coordinate coord) {
+  if (coord.getX() < 0 || coord.getX() >= VIEW_WIDTH || coord.getY() < 0 ||
+      coord.getY() >= VIEW_HEIGHT)
+    return nullptr;
+
+  return &cells_[coord.getX() + coord.getY() * VIEW_WIDTH];
+}
+
+uint32_t StudentWorld::idleActorTypes() {
+  // Food and pebbles never do anything on their turn.
+  return ActorCell::typeBit(ActorType::FOOD) |
+         ActorCell::typeBit(ActorType::PEBBLE);
+}
+
+void StudentWorld::markCellToVisit(ActorCell *cell) {
+  int index = cell - cells_;
+  cells_to_visit_[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+int StudentWorld::nextCellToVisit(int from) const {
+  if (from >= kNumCells) return kNumCells;
+
+  // Skip the bits for the cells before the one to start from.
+  int word = from / 64;
+  uint64_t bits = cells_to_visit_[word] & (~uint64_t(0) << (from % 64));
+  while (bits == 0) {
+    if (++word >= (kNumCells + 63) / 64) return kNumCells;
+    bits = cells_to_visit_[word];
   }
+  int index = word * 64;
+#if defined(__GNUC__)
+  index += __builtin_ctzll(bits);
+#else
+  for (; (bits & 1) == 0; bits >>= 1) index++;
+#endif
+  return index < kNumCells ? index : kNumCells;
+}
+
+void StudentWorld::countInstructions(int instructions) {
+  instructions_run_ += instructions;
+  ant_ticks_run_++;
+}
+long StudentWorld::getInstructionsRun() const { return instructions_run_; }
+long StudentWorld::getAntTicksRun() const { return ant_ticks_run_; }
+
+int StudentWorld::getNumColonies() const { return ant_hills_on_field_; }
+std::string StudentWorld::getColonyName(int colony) const {
+  return scoreboard_names_[colony];
+}
+int StudentWorld::getScore(int colony) const { return scoreboard_[colony]; }
+int StudentWorld::getWinningColony() const { return leader_; }
+
+void StudentWorld::setSeed(uint64_t seed) {
+  seed_ = seed;
+  has_seed_ = true;
+}
+
+int StudentWorld::randInt(int min, int max) {
+  return random_.randInt(min, max);
+}
+bool StudentWorld::isColonyNative(int colony) const {
+  return programs_[colony] != nullptr && programs_[colony]->isNative();
+}
+
+void StudentWorld::setNativePrograms(
+    const AntProgram::NativeProgram *programs, int num_programs) {
+  native_programs_ = programs;
+  num_native_programs_ = num_programs;
+}
+
+void StudentWorld::setOptimizePrograms(bool optimize) {
+  optimize_programs_ = optimize;
+}
 
-  // Key does not exist, so create a new coordinate key and add the actor to
-  // that list.
-  std::list<Actor *> actors_at_point;
-  actors_at_point.push_back(actor);
-  actors_[actor->getCoord()] = actors_at_point;
+void StudentWorld::setPopulationScale(int scale) {
+  population_scale_ = scale;
 }
 
 void StudentWorld::updateScoreboard(int colony) {
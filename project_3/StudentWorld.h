@@ -1,13 +1,17 @@
 #ifndef STUDENTWORLD_H_
 #define STUDENTWORLD_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <list>
 
 #include "GameWorld.h"
 #include "GameConstants.h"
+#include "GraphObject.h"
 #include "Compiler.h"
+#include "AntProgram.h"
+#include "Random.h"
 
 class Actor;
 enum class ActorType;
@@ -30,6 +34,53 @@ class Coordinate {
   int x_, y_;
 };
 
+// Actors on a single square of the field, in the order they were added. The
+// first few are stored inline and the rest in an overflow array that never
+// shrinks, so that once a square has held as many actors as it will, adding
+// and removing actors there allocates nothing. The cell also counts the
+// actors of each type on it, and keeps a mask with a bit set for each type
+// it holds, so that asking whether a square holds any of a set of types is a
+// single test of that mask.
+class ActorCell {
+ public:
+  // One for each ActorType.
+  static const int kNumActorTypes = 17;
+
+  ActorCell();
+
+  // The bit for an actor type in the mask of types.
+  static std::uint32_t typeBit(ActorType type);
+
+  int size() const;
+  // The actor at an index, or nullptr for one that was removed.
+  Actor *operator[](int i) const;
+  void push_back(Actor *actor);
+  // Remove the actor at an index, leaving a nullptr in its place so that the
+  // indices of the rest do not change.
+  void remove(int i);
+  // Drop the entries left behind by actors that moved away or were deleted,
+  // keeping the order of the rest.
+  void removeNulls();
+  void clear();
+
+  // Mask of the types of the actors on the square, dead or alive.
+  std::uint32_t types() const;
+  // The first actor of a type on the square, or nullptr if there is none.
+  Actor *firstOfType(ActorType type) const;
+
+ private:
+  static const int kInlineActors = 4;
+
+  Actor *&slot(int i);
+  void count(Actor *actor, int delta);
+
+  Actor *inline_[kInlineActors];
+  std::vector<Actor *> overflow_;
+  int size_;
+  std::uint16_t type_counts_[kNumActorTypes];
+  std::uint32_t types_;
+};
+
 class StudentWorld : public GameWorld {
  public:
   StudentWorld(std::string assetDir);
@@ -40,32 +91,104 @@ class StudentWorld : public GameWorld {
   virtual int move();
   virtual void cleanUp();
 
-  // Add items to the field at their proper positions in the STL map data
-  // structure used in this project.
+  // Add items to the field at their proper positions in the grid.
   void addActor(Actor *actor);
   void addFood(Coordinate coord, int food_points);
   void addPheromone(Coordinate coord, int pheromone_points,
                     int colony);
 
-  // Updater to sync up actor coordinates with the order of actors in the STL
-  // map.
+  // Updater to sync up actor coordinates with the cells of the grid.
   void updatePositionInGrid(Actor *actor, Coordinate to_coord);
+  // Updater for an actor that died, which is deleted from its cell when the
+  // cell is next visited.
+  void updateDeathInGrid(Actor *actor);
 
   // Methods of searching for specific types of actors at a given coordinate.
   std::list<Actor *> actorsOfTypeAt(ActorType actor_type, Coordinate coord);
   std::list<Actor *> actorsOfTypesAt(std::vector<ActorType> actor_types,
                                      Coordinate to_coord);  // Plural type form.
+  // The first actor of a type at a coordinate, or nullptr if there is none.
+  Actor *actorOfTypeAt(ActorType actor_type, Coordinate coord);
+  // Mask of the types of the actors at a coordinate (see ActorCell::typeBit),
+  // which is empty off the field. Dead actors count until they are deleted,
+  // as they do in the lists above.
+  std::uint32_t actorTypesAt(Coordinate coord);
   // Updater for game ticker text and scoreboard.
   void updateGameStatText();
   void updateScoreboard(int colony);
 
+  // Tally of the bug program instructions that ants have run, and of the
+  // ticks they ran them in, for benchmarking the interpreter.
+  void countInstructions(int instructions);
+  long getInstructionsRun() const;
+  long getAntTicksRun() const;
+
+  // Number of colonies playing, and for each of them its name and the number
+  // of ants it has produced.
+  int getNumColonies() const;
+  std::string getColonyName(int colony) const;
+  int getScore(int colony) const;
+  // Colony that won the match once it is over, or -1 if none did.
+  int getWinningColony() const;
+
+  // Seed for the random numbers that init starts each game from, so that
+  // games with the same seed play out the same. Without one, every game is
+  // seeded differently.
+  void setSeed(std::uint64_t seed);
+  // Return a uniformly distributed random int from min to max, inclusive,
+  // from this world's generator.
+  int randInt(int min, int max);
+  // Whether the ants of a colony run a translation of its program.
+  bool isColonyNative(int colony) const;
+
+  // Translations of bug programs that init may run instead of interpreting
+  // the programs they were translated from. The programs are not copied.
+  void setNativePrograms(const AntProgram::NativeProgram *programs,
+                         int num_programs);
+  // Whether init optimizes the bug programs it compiles, which ants run the
+  // same either way (see Compiler::optimize).
+  void setOptimizePrograms(bool optimize);
+  // How many times the usual food ant hills start with, beyond what they
+  // keep in reserve, so that benchmarks can play with larger colonies.
+  void setPopulationScale(int scale);
+
  private:
   Compiler *handleNewCompiler(int colony);
-  std::map<Coordinate, std::list<Actor*>> actors_;
+  static const int kNumCells = VIEW_WIDTH * VIEW_HEIGHT;
+
+  // The cell of a coordinate, or nullptr for coordinates off the field.
+  ActorCell *cellAt(Coordinate coord);
+
+  // Types of the actors that do nothing on their turn, so that a cell that
+  // holds only these has nothing to do in a tick.
+  static std::uint32_t idleActorTypes();
+  // Mark a cell to be visited on the next tick, or on this one if the tick
+  // has yet to reach it.
+  void markCellToVisit(ActorCell *cell);
+  // The first cell from an index on that is marked to be visited, or
+  // kNumCells if there are none.
+  int nextCellToVisit(int from) const;
+
+  // Every square of the field, row by row from the bottom.
+  ActorCell cells_[kNumCells];
+  // A bit for each cell, set for the cells that move visits: those that hold
+  // actors that act, and those where an actor moved away or died since they
+  // were last visited. Every other cell holds only idle actors, and visiting
+  // it would do nothing.
+  std::uint64_t cells_to_visit_[(kNumCells + 63) / 64];
   std::string scoreboard_names_[4];
-  Compiler *compilers_[4];
+  AntProgram *programs_[4];
+  const AntProgram::NativeProgram *native_programs_;
+  int num_native_programs_;
 
   int ticks_;
+  long instructions_run_;
+  long ant_ticks_run_;
+  bool optimize_programs_;
+  int population_scale_;
+  Random random_;
+  std::uint64_t seed_;
+  bool has_seed_;
   int scoreboard_[4];
   int leader_;
   int ant_hills_on_field_;
@@ -0,0 +1,54 @@
+#include "WorkStealingPool.h"
+
+#include <thread>
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(int num_threads)
+    : queues_(num_threads < 1 ? 1 : num_threads) {}
+
+int WorkStealingPool::getNumThreads() const { return queues_.size(); }
+
+void WorkStealingPool::run(const vector<Task> &tasks) {
+  for (int i = 0; i < tasks.size(); i++)
+    queues_[i % queues_.size()].tasks.push_back(&tasks[i]);
+
+  // The calling thread works as thread 0 rather than wait.
+  vector<thread> threads;
+  for (int i = 1; i < queues_.size(); i++)
+    threads.push_back(thread(&WorkStealingPool::work, this, i));
+  work(0);
+  for (int i = 0; i < threads.size(); i++) threads[i].join();
+}
+
+void WorkStealingPool::work(int thread) {
+  for (;;) {
+    const Task *task = takeTask(thread);
+    if (task == nullptr) return;
+    (*task)(thread);
+  }
+}
+
+const WorkStealingPool::Task *WorkStealingPool::takeTask(int thread) {
+  {
+    Queue &own = queues_[thread];
+    lock_guard<mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      const Task *task = own.tasks.back();
+      own.tasks.pop_back();
+      return task;
+    }
+  }
+
+  // Look through the other queues, starting with the next thread's, so
+  // that idle threads spread their stealing out.
+  for (int i = 1; i < queues_.size(); i++) {
+    Queue &other = queues_[(thread + i) % queues_.size()];
+    lock_guard<mutex> lock(other.mutex);
+    if (!other.tasks.empty()) {
+      const Task *task = other.tasks.front();
+      other.tasks.pop_front();
+      return task;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,47 @@
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs a batch of independent tasks on a fixed number of threads. The tasks
+// are dealt out to the threads in turn, and each thread runs its own from
+// the back of its queue. A thread that runs out takes tasks from the front
+// of the others' queues, so that threads that drew short tasks help out
+// those that drew long ones until the batch is done.
+class WorkStealingPool {
+ public:
+  // A task is given the number of the thread running it, from 0 up to the
+  // number of threads, so that it can use state that thread owns.
+  typedef std::function<void(int thread)> Task;
+
+  explicit WorkStealingPool(int num_threads);
+
+  int getNumThreads() const;
+
+  // Run every task, and return once they have all finished. Tasks must not
+  // add more tasks.
+  void run(const std::vector<Task> &tasks);
+
+  // We prevent a WorkStealingPool object from being copied or assigned.
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<const Task *> tasks;
+  };
+
+  // Run tasks on one thread until there are none left in any queue.
+  void work(int thread);
+  // Take a task from the back of the thread's own queue, or else from the
+  // front of another's. Returns nullptr if every queue is empty.
+  const Task *takeTask(int thread);
+
+  std::vector<Queue> queues_;
+};
+
+#endif  // WORKSTEALINGPOOL_H_
@@ -0,0 +1,153 @@
+// Benchmark for Bugs. Plays whole matches between the given colonies on a
+// field, without a window (see headless.cpp), and times how many ticks of the
+// simulation, and how many bug program instructions, run per second. Run it
+// with
+//  ./BugsBench [field.txt] [USCAnt.bug ...] [-games N] [-seed N] [-native]
+//      [-optimize] [-population N]
+// which defaults to the bundled field and colonies. With -seed N, the first
+// match is seeded with N, the next with N + 1, and so on, so that a run can
+// be repeated exactly. -native runs the colonies translated to C++ when
+// BugsBench was built as native code, and -optimize optimizes the programs
+// first, as they do for BugsHeadless. -population N starts the ant hills
+// with N times the food they usually have to give birth with, for timing
+// the world with about N times as many ants. The results are printed as CSV,
+// one row per match and a last row over all of them, so that runs can be
+// compared against each other to catch regressions. They include the
+// instructions that ants ran per tick, and how many ants ran their programs
+// per tick.
+// ConditionBench.bug is a colony whose ants mostly test what is on the
+// squares around them, for timing the world's lookups of actors rather than
+// the interpreter, as in
+//  ./BugsBench field.txt ConditionBench.bug ConditionBench.bug
+
+#include "NativePrograms.h"
+#include "StudentWorld.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct MatchOptions {
+  bool native;
+  bool optimize;
+  bool has_seed;
+  unsigned long long seed;
+  int population_scale;
+};
+
+struct MatchResult {
+  int ticks;
+  long instructions;  // Bug program instructions run by every ant.
+  long ant_ticks;     // Ticks in which an ant ran its program.
+  double seconds;
+  string winner;
+};
+
+// Play a match through to its end, as BugsHeadless does. Returns false if the
+// match could not be set up.
+bool playMatch(const string &field_file, const vector<string> &bug_files,
+               const MatchOptions &options, MatchResult &result) {
+  StudentWorld world("");
+  world.addParameter(field_file);
+  for (int i = 0; i < bug_files.size(); i++) world.addParameter(bug_files[i]);
+  if (options.native)
+    world.setNativePrograms(kNativePrograms, kNumNativePrograms);
+  world.setOptimizePrograms(options.optimize);
+  world.setPopulationScale(options.population_scale);
+  if (options.has_seed) world.setSeed(options.seed);
+
+  result.ticks = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  int status = world.init();
+  while (status == GWSTATUS_CONTINUE_GAME) {
+    status = world.move();
+    result.ticks++;
+  }
+  result.instructions = world.getInstructionsRun();
+  result.ant_ticks = world.getAntTicksRun();
+  world.cleanUp();
+  result.seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  if (status == GWSTATUS_LEVEL_ERROR) {
+    cerr << "Cannot play match: " << world.getError() << endl;
+    return false;
+  }
+  result.winner = world.getWinnerName();
+  return true;
+}
+
+void printRow(const string &match, int ticks, long instructions,
+              long ant_ticks, double seconds, const string &winner) {
+  cout << match << "," << ticks << "," << instructions << ","
+       << static_cast<double>(instructions) / ant_ticks << ","
+       << static_cast<double>(ant_ticks) / ticks << "," << seconds << ","
+       << ticks / seconds << "," << instructions / seconds << "," << winner
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  string field_file = "field.txt";
+  vector<string> bug_files;
+  int num_games = 5;
+  bool have_field = false;
+  MatchOptions options = MatchOptions();
+  options.population_scale = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-games") == 0 && i + 1 < argc) {
+      num_games = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      options.seed = strtoull(argv[++i], nullptr, 0);
+      options.has_seed = true;
+    } else if (strcmp(argv[i], "-native") == 0) {
+      options.native = true;
+    } else if (strcmp(argv[i], "-optimize") == 0) {
+      options.optimize = true;
+    } else if (strcmp(argv[i], "-population") == 0 && i + 1 < argc) {
+      options.population_scale = atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      // The field comes first, and every file after it is a colony.
+      if (!have_field)
+        field_file = argv[i];
+      else
+        bug_files.push_back(argv[i]);
+      have_field = true;
+    } else {
+      cerr << "Usage: BugsBench [field.txt] [colony.bug ...] [-games N] "
+              "[-seed N] [-native] [-optimize] [-population N]"
+           << endl;
+      return 1;
+    }
+  }
+  if (bug_files.empty()) {
+    bug_files.push_back("USCAnt.bug");
+    bug_files.push_back("UCLAAnt.bug");
+  }
+
+  cout << "match,ticks,instructions,instructions_per_ant_tick,"
+          "ant_ticks_per_tick,seconds,ticks_per_second,"
+          "instructions_per_second,winner"
+       << endl;
+
+  int total_ticks = 0;
+  long total_instructions = 0, total_ant_ticks = 0;
+  double total_seconds = 0;
+  for (int i = 0; i < num_games; i++) {
+    MatchResult result;
+    if (!playMatch(field_file, bug_files, options, result)) return 1;
+    options.seed++;
+    printRow(to_string(i + 1), result.ticks, result.instructions,
+             result.ant_ticks, result.seconds, result.winner);
+    total_ticks += result.ticks;
+    total_instructions += result.instructions;
+    total_ant_ticks += result.ant_ticks;
+    total_seconds += result.seconds;
+  }
+  printRow("all", total_ticks, total_instructions, total_ant_ticks,
+           total_seconds, "");
+}
@@ -0,0 +1,221 @@
+// Ahead-of-time translator for bug programs. Compiles each given program and
+// writes it out as a C++ function that runs a tick of it for an ant exactly
+// as AntProgram::run does, once as compiled and once optimized, followed by
+// a table of every function with the colony it plays and the fingerprint of
+// the program it came from. Run it with
+//  ./BugsTranslate NativePrograms.cpp USCAnt.bug [UCLAAnt.bug ...]
+// and link the output into a driver, which can then hand the table to
+// StudentWorld::setNativePrograms (see NativePrograms.h).
+//
+// Each instruction becomes a labeled block, and goto and if become gotos
+// between the blocks, so that the state of the ant's program is kept in
+// where the function is running rather than in its instruction counter.
+// Every block still counts itself against the tick's budget before it runs,
+// so that the ant spends exactly the instructions that interpreting it
+// would.
+
+#include "AntProgram.h"
+#include "Compiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// The Ant method that tests each Compiler::Condition.
+const char *const kConditionMethods[] = {
+    "smellDangerInFront",    "smellPheromoneInFront", "wasBit",
+    "isCarryingFood",        "isHungry",              "isStandingOnMyAntHill",
+    "isStandingOnFood",      "isStandingWithEnemy",   "wasBlockedFromMoving",
+    "lastRandomNumberWasZero"};
+
+// The call that takes the action of an instruction, or an empty string for
+// instructions that are not actions.
+string actionCall(const Compiler::Instruction &instruction) {
+  switch (instruction.opcode) {
+    case Compiler::emitPheromone:
+      return "emitPheromone()";
+    case Compiler::faceRandomDirection:
+      return "faceRandomDirection()";
+    case Compiler::rotateClockwise:
+      return "rotateClockwise()";
+    case Compiler::rotateCounterClockwise:
+      return "rotateCounterClockwise()";
+    case Compiler::moveForward:
+      return "moveForward()";
+    case Compiler::bite:
+      return "biteEnemy()";
+    case Compiler::pickupFood:
+      return "pickUpFood()";
+    case Compiler::dropFood:
+      return "dropFood()";
+    case Compiler::eatFood:
+      return "eatFood()";
+    case Compiler::generateRandomNumber:
+      return "generateRandomNumber(" + to_string(instruction.operand) + ")";
+    default:
+      return "";
+  }
+}
+
+// A C++ string literal of text.
+string quoted(const string &text) {
+  string literal = "\"";
+  for (int i = 0; i < text.size(); i++) {
+    if (text[i] == '"' || text[i] == '\\') literal += '\\';
+    literal += text[i];
+  }
+  return literal + "\"";
+}
+
+// Jump to instruction target, which may be outside of the program.
+string jumpTo(int target, int size, bool &uses_outside) {
+  if (target >= 0 && target < size) return "goto i" + to_string(target) + ";";
+  uses_outside = true;
+  return "{ pc = " + to_string(target) + "; goto outside; }";
+}
+
+// Write the jump of a goto or if, threaded past the gotos it leads to when
+// enough of the budget is left, as AntProgram does.
+void writeJump(const Compiler::Instruction &instruction, int size,
+               const string &indent, bool &uses_outside, ostream &out) {
+  if (instruction.cost > 1) {
+    int skipped = instruction.cost - 1;
+    out << indent << "if (charged + " << skipped
+        << " <= AntProgram::kInstructionsPerTick) {\n";
+    out << indent << "  charged += " << skipped << ";\n";
+    out << indent << "  "
+        << jumpTo(instruction.threadedOperand, size, uses_outside) << "\n";
+    out << indent << "}\n";
+  }
+  out << indent << jumpTo(instruction.operand, size, uses_outside) << "\n";
+}
+
+// Write the function that runs a tick of a compiled program.
+void translate(const Compiler &compiler, const string &function,
+               const string &source_file, ostream &out) {
+  const vector<Compiler::Instruction> &instructions =
+      compiler.getInstructions();
+  int size = instructions.size();
+  bool uses_outside = false;
+
+  ostringstream body;
+  for (int i = 0; i < size; i++) {
+    const Compiler::Instruction &instruction = instructions[i];
+    Compiler::Command command;
+    compiler.getCommand(i, command);
+    string text = command.text;
+    text.erase(0, text.find_first_not_of(" \t"));
+    // A backslash would continue the comment onto the next line.
+    text.erase(remove(text.begin(), text.end(), '\\'), text.end());
+
+    body << "\ni" << i << ":  // " << text << "\n";
+    body << "  if (charged == AntProgram::kInstructionsPerTick) {\n";
+    body << "    pc = " << i << ";\n";
+    body << "    return true;\n";
+    body << "  }\n";
+    body << "  executed++;\n";
+    body << "  charged++;\n";
+
+    if (instruction.opcode == Compiler::goto_command) {
+      writeJump(instruction, size, "  ", uses_outside, body);
+      continue;
+    }
+    if (instruction.opcode == Compiler::if_command &&
+        instruction.condition <= Compiler::last_random_number_was_zero) {
+      body << "  if (ant." << kConditionMethods[instruction.condition]
+           << "()) {\n";
+      writeJump(instruction, size, "    ", uses_outside, body);
+      body << "  }\n";
+      // Fall through to the next instruction, unless this is the last one.
+      if (i + 1 == size)
+        body << "  " << jumpTo(size, size, uses_outside) << "\n";
+      continue;
+    }
+
+    string action = actionCall(instruction);
+    if (action.empty()) {
+      body << "  std::cerr << \"INVALID COMMAND\" << std::endl;\n";
+      action = "die()";
+    }
+    body << "  ant." << action << ";\n";
+    body << "  pc = " << i + 1 << ";\n";
+    body << "  return true;\n";
+  }
+
+  out << "\n// " << compiler.getColonyName() << ", from " << source_file
+      << ".\n";
+  out << "static bool " << function
+      << "(Ant &ant, int &pc, int &executed) {\n";
+  out << "  int charged = 0;\n";
+  out << "  executed = 0;\n";
+  out << "  switch (pc) {\n";
+  for (int i = 0; i < size; i++)
+    out << "    case " << i << ": goto i" << i << ";\n";
+  out << "    default: return false;\n";
+  out << "  }\n";
+  out << body.str();
+  if (uses_outside) {
+    // Reaching an instruction outside of the program kills the ant, but only
+    // once it tries to run it.
+    out << "\noutside:\n";
+    out << "  return charged == AntProgram::kInstructionsPerTick;\n";
+  }
+  out << "}\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    cerr << "Usage: BugsTranslate output.cpp colony.bug [colony.bug ...]"
+         << endl;
+    return 1;
+  }
+
+  ostringstream out;
+  out << "// Generated by BugsTranslate from";
+  for (int i = 2; i < argc; i++) out << " " << argv[i];
+  out << ". Do not edit.\n\n";
+  out << "#include \"NativePrograms.h\"\n\n";
+  out << "#include <iostream>\n\n";
+  out << "#include \"Actor.h\"\n";
+
+  vector<string> colony_names;
+  vector<AntProgram *> programs;
+  for (int i = 2; i < argc; i++) {
+    Compiler compiler;
+    string error;
+    if (!compiler.compile(argv[i], error)) {
+      cerr << "Cannot compile " << argv[i] << ": " << error << endl;
+      return 1;
+    }
+    // Translate the program both as compiled and optimized, so that there
+    // is a translation to run whether or not the world optimizes programs.
+    for (int optimized = 0; optimized < 2; optimized++) {
+      if (optimized) compiler.optimize();
+      translate(compiler, "runProgram" + to_string(programs.size()), argv[i],
+                out);
+      colony_names.push_back(compiler.getColonyName());
+      programs.push_back(new AntProgram(compiler));
+    }
+  }
+
+  out << "\nconst AntProgram::NativeProgram kNativePrograms[] = {\n";
+  for (int i = 0; i < programs.size(); i++) {
+    out << "    {" << quoted(colony_names[i]) << ", 0x" << hex
+        << programs[i]->fingerprint() << dec << "ULL, runProgram" << i
+        << "},\n";
+    delete programs[i];
+  }
+  out << "};\n\n";
+  out << "const int kNumNativePrograms = " << programs.size() << ";\n";
+
+  ofstream file(argv[1]);
+  file << out.str();
+  if (!file) {
+    cerr << "Cannot write " << argv[1] << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,77 @@
+// Headless driver for Bugs. Plays a single match between the given colonies
+// on a field as fast as the simulation runs, without a window, then prints
+// the winner and how many ants each colony produced. Run it with
+//  ./BugsHeadless [-seed N] [-native] [-optimize] field.txt USCAnt.bug
+//      [UCLAAnt.bug ...]
+// It exits with status 1 if the match could not be set up. Matches played
+// with the same -seed play out the same, and without one, each is seeded
+// differently. With -native, colonies whose programs were translated to C++
+// when it was built (see bugtranslate.cpp) run as native code, and with
+// -optimize, programs are optimized before they run (see
+// Compiler::optimize). Either way the match played is the same.
+
+#include "NativePrograms.h"
+#include "StudentWorld.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+using namespace std;
+
+int main(int argc, char *argv[]) {
+  bool native = false, optimize = false, has_seed = false;
+  unsigned long long seed = 0;
+  int first_file = 1;
+  for (; first_file < argc && argv[first_file][0] == '-'; first_file++) {
+    if (strcmp(argv[first_file], "-native") == 0) {
+      native = true;
+    } else if (strcmp(argv[first_file], "-optimize") == 0) {
+      optimize = true;
+    } else if (strcmp(argv[first_file], "-seed") == 0 &&
+               first_file + 1 < argc) {
+      seed = strtoull(argv[++first_file], nullptr, 0);
+      has_seed = true;
+    } else {
+      break;
+    }
+  }
+  if (argc - first_file < 2 || argv[first_file][0] == '-') {
+    cerr << "Usage: BugsHeadless [-seed N] [-native] [-optimize] field.txt "
+            "colony.bug [colony.bug ...]"
+         << endl;
+    return 1;
+  }
+
+  StudentWorld world("");
+  for (int i = first_file; i < argc; i++) world.addParameter(argv[i]);
+  if (has_seed) world.setSeed(seed);
+  if (native) world.setNativePrograms(kNativePrograms, kNumNativePrograms);
+  world.setOptimizePrograms(optimize);
+
+  int status = world.init();
+  for (int i = 0; native && i < world.getNumColonies(); i++) {
+    if (!world.isColonyNative(i)) {
+      cerr << "No translation of " << world.getColonyName(i)
+           << ", so interpreting it" << endl;
+    }
+  }
+  int ticks = 0;
+  while (status == GWSTATUS_CONTINUE_GAME) {
+    status = world.move();
+    ticks++;
+  }
+
+  if (status == GWSTATUS_LEVEL_ERROR) {
+    cerr << "Cannot play match: " << world.getError() << endl;
+    world.cleanUp();
+    return 1;
+  }
+
+  cout << "Winner: " << world.getWinnerName() << endl;
+  for (int i = 0; i < world.getNumColonies(); i++)
+    cout << world.getColonyName(i) << ": " << world.getScore(i) << endl;
+  cout << "Ticks: " << ticks << endl;
+
+  world.cleanUp();
+}
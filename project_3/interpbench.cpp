@@ -0,0 +1,101 @@
+// Micro-benchmark for the bug program interpreter. Runs a program for many
+// ants, each with its own instruction counter, through both the threaded and
+// the switch interpreter of AntProgram, and times how many instructions each
+// runs per second. Run it with
+//  ./BugsInterpBench [program.bug] [-ants N] [-ticks N]
+// which defaults to InterpBench.bug. The ants are not on a field, so the
+// program should only test conditions about the ant itself, and only rotate
+// or generate random numbers.
+
+#include "Actor.h"
+#include "AntProgram.h"
+#include "Compiler.h"
+#include "StudentWorld.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Run every ant for the given number of ticks, with either interpreter, and
+// return the number of instructions run.
+long runTicks(const AntProgram &program, const vector<Ant *> &ants,
+              vector<int> &pcs, int ticks, bool threaded) {
+  long instructions = 0;
+  for (int tick = 0; tick < ticks; tick++) {
+    for (int i = 0; i < ants.size(); i++) {
+      int executed;
+      bool in_program =
+          threaded ? program.run(*ants[i], pcs[i], executed)
+                   : program.runSwitch(*ants[i], pcs[i], executed);
+      // Start again rather than kill ants that run off the program.
+      if (!in_program) pcs[i] = 0;
+      instructions += executed;
+    }
+  }
+  return instructions;
+}
+
+void printRow(const string &interpreter, long instructions, double seconds) {
+  cout << interpreter << "," << instructions << "," << seconds << ","
+       << instructions / seconds << "," << seconds / instructions * 1e9
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  string program_file = "InterpBench.bug";
+  int num_ants = 10000, ticks = 1000;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-ants") == 0 && i + 1 < argc) {
+      num_ants = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc) {
+      ticks = atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      program_file = argv[i];
+    } else {
+      cerr << "Usage: BugsInterpBench [program.bug] [-ants N] [-ticks N]"
+           << endl;
+      return 1;
+    }
+  }
+
+  Compiler compiler;
+  string error;
+  if (!compiler.compile(program_file, error)) {
+    cerr << "Cannot compile " << program_file << ": " << error << endl;
+    return 1;
+  }
+  AntProgram program(compiler);
+
+  // The ants belong to a world that is never initialized, and to an anthill
+  // that is never run.
+  StudentWorld world("");
+  Coordinate coord(VIEW_WIDTH / 2, VIEW_HEIGHT / 2);
+  AntHill ant_hill(world, 0, coord, &program, 1);
+  vector<Ant *> ants;
+  for (int i = 0; i < num_ants; i++)
+    ants.push_back(new Ant(world, 0, coord, &program, ant_hill, 1 << 30));
+
+  cout << "interpreter,instructions,seconds,instructions_per_second,"
+          "ns_per_instruction"
+       << endl;
+
+  // Run each interpreter from the same instruction counters, warmed up by a
+  // few ticks that are not timed.
+  for (int threaded = 1; threaded >= 0; threaded--) {
+    vector<int> pcs(num_ants, 0);
+    runTicks(program, ants, pcs, 10, threaded);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long instructions = runTicks(program, ants, pcs, ticks, threaded);
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printRow(threaded ? "threaded" : "switch", instructions, seconds);
+  }
+
+  for (int i = 0; i < ants.size(); i++) delete ants[i];
+}
@@ -0,0 +1,189 @@
+// Tournament runner for Bugs. Plays every pairing of the given colonies, in
+// both seatings, on every given field, as many times as asked, spread over a
+// pool of threads. Run it with
+//  ./BugsTournament [-threads N] [-games N] [-seed N] [-native] [-optimize]
+//      field.txt [field.txt ...] A.bug B.bug [C.bug ...]
+// Files that end in .bug are colonies, and the rest are fields. Every match
+// gets a seed of its own: with -seed N, they are N, N + 1 and so on, in the
+// order the matches are listed, so that a tournament can be replayed exactly
+// however its matches are spread over the threads. -native and -optimize
+// are as for BugsHeadless. The results are printed as CSV, with a
+// row for each colony against each opponent, and a row against all of them,
+// giving the matches it won, lost and that nobody won.
+
+#include "NativePrograms.h"
+#include "StudentWorld.h"
+#include "WorkStealingPool.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+struct MatchOptions {
+  bool native;
+  bool optimize;
+  bool has_seed;
+};
+
+struct Match {
+  int field;
+  unsigned long long seed;
+  int colonies[2];  // In the order they are seated on the field.
+  int winner;       // Seat of the colony that won, or -1 if none did.
+  bool played;
+};
+
+struct Record {
+  int games;
+  int wins;
+  int losses;
+};
+
+bool endsWith(const string &text, const string &suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Play a match through to its end, in a world of its own. Returns false if
+// the match could not be set up.
+bool playMatch(const string &field_file, const string (&bug_files)[2],
+               const MatchOptions &options, Match &match) {
+  StudentWorld world("");
+  world.addParameter(field_file);
+  world.addParameter(bug_files[0]);
+  world.addParameter(bug_files[1]);
+  if (options.native)
+    world.setNativePrograms(kNativePrograms, kNumNativePrograms);
+  world.setOptimizePrograms(options.optimize);
+  if (options.has_seed) world.setSeed(match.seed);
+
+  int status = world.init();
+  while (status == GWSTATUS_CONTINUE_GAME) status = world.move();
+  match.winner = world.getWinningColony();
+  world.cleanUp();
+
+  if (status == GWSTATUS_LEVEL_ERROR) {
+    cerr << "Cannot play match: " << world.getError() << endl;
+    return false;
+  }
+  return true;
+}
+
+void printRow(const string &colony, const string &opponent,
+              const Record &record) {
+  int no_winner = record.games - record.wins - record.losses;
+  cout << colony << "," << opponent << "," << record.games << ","
+       << record.wins << "," << record.losses << "," << no_winner << ","
+       << (record.games == 0 ? 0 : double(record.wins) / record.games)
+       << endl;
+}
+
+int main(int argc, char *argv[]) {
+  vector<string> field_files, bug_files;
+  int num_threads = thread::hardware_concurrency();
+  int num_games = 1;
+  MatchOptions options = MatchOptions();
+  unsigned long long seed = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-games") == 0 && i + 1 < argc) {
+      num_games = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], nullptr, 0);
+      options.has_seed = true;
+    } else if (strcmp(argv[i], "-native") == 0) {
+      options.native = true;
+    } else if (strcmp(argv[i], "-optimize") == 0) {
+      options.optimize = true;
+    } else if (argv[i][0] != '-' && endsWith(argv[i], ".bug")) {
+      bug_files.push_back(argv[i]);
+    } else if (argv[i][0] != '-') {
+      field_files.push_back(argv[i]);
+    } else {
+      field_files.clear();
+      break;
+    }
+  }
+  if (field_files.empty() || bug_files.size() < 2) {
+    cerr << "Usage: BugsTournament [-threads N] [-games N] [-seed N] "
+            "[-native] [-optimize] field.txt [field.txt ...] A.bug B.bug "
+            "[C.bug ...]"
+         << endl;
+    return 1;
+  }
+
+  // Every colony plays every other from both seats, on every field.
+  vector<Match> matches;
+  for (int field = 0; field < field_files.size(); field++) {
+    for (int a = 0; a < bug_files.size(); a++) {
+      for (int b = 0; b < bug_files.size(); b++) {
+        if (a == b) continue;
+        for (int game = 0; game < num_games; game++) {
+          Match match;
+          match.field = field;
+          match.seed = seed + matches.size();
+          match.colonies[0] = a;
+          match.colonies[1] = b;
+          match.winner = -1;
+          match.played = false;
+          matches.push_back(match);
+        }
+      }
+    }
+  }
+
+  // Each task writes only to its own match, so they need no locking.
+  vector<WorkStealingPool::Task> tasks;
+  for (int i = 0; i < matches.size(); i++) {
+    Match *match = &matches[i];
+    tasks.push_back([&, match](int) {
+      string match_bug_files[2] = {bug_files[match->colonies[0]],
+                                   bug_files[match->colonies[1]]};
+      match->played = playMatch(field_files[match->field], match_bug_files,
+                                options, *match);
+    });
+  }
+
+  WorkStealingPool pool(num_threads);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  pool.run(tasks);
+  double seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  int num_colonies = bug_files.size();
+  vector<vector<Record>> records(num_colonies,
+                                 vector<Record>(num_colonies, Record()));
+  for (int i = 0; i < matches.size(); i++) {
+    const Match &match = matches[i];
+    if (!match.played) return 1;
+    for (int seat = 0; seat < 2; seat++) {
+      Record &record = records[match.colonies[seat]][match.colonies[1 - seat]];
+      record.games++;
+      if (match.winner == seat) record.wins++;
+      if (match.winner == 1 - seat) record.losses++;
+    }
+  }
+
+  cout << "colony,opponent,games,wins,losses,no_winner,win_rate" << endl;
+  for (int a = 0; a < num_colonies; a++) {
+    Record total = Record();
+    for (int b = 0; b < num_colonies; b++) {
+      if (a == b) continue;
+      printRow(bug_files[a], bug_files[b], records[a][b]);
+      total.games += records[a][b].games;
+      total.wins += records[a][b].wins;
+      total.losses += records[a][b].losses;
+    }
+    printRow(bug_files[a], "all", total);
+  }
+
+  cerr << matches.size() << " matches on " << pool.getNumThreads()
+       << " threads in " << seconds << " s" << endl;
+}
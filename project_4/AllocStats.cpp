@@ -0,0 +1,105 @@
+#include "AllocStats.h"
+
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+#ifdef ALLOC_STATS
+
+// Each thread counts its own calls, so that counting needs no locking and a
+// query is not charged for allocations made by queries on other threads.
+// These are zero-initialized before any code runs, so they can be used by
+// allocations made during static initialization.
+static thread_local long thread_allocations = 0;
+static thread_local long thread_frees = 0;
+static thread_local long thread_bytes = 0;
+
+AllocCounts threadAllocCounts() {
+  AllocCounts counts;
+  counts.allocations = thread_allocations;
+  counts.frees = thread_frees;
+  counts.bytes = thread_bytes;
+  return counts;
+}
+
+// Allocate as the standard operator new does, retrying through the new
+// handler until it gives up. Returns nullptr when it does.
+static void *countedAllocate(size_t size) {
+  thread_allocations++;
+  thread_bytes += size;
+  if (size == 0) size = 1;
+
+  for (;;) {
+    void *block = malloc(size);
+    if (block != nullptr) return block;
+
+    new_handler handler = get_new_handler();
+    if (handler == nullptr) return nullptr;
+    handler();
+  }
+}
+
+static void countedFree(void *block) {
+  if (block == nullptr) return;
+  thread_frees++;
+  free(block);
+}
+
+void *operator new(size_t size) {
+  void *block = countedAllocate(size);
+  if (block == nullptr) throw bad_alloc();
+  return block;
+}
+
+void *operator new[](size_t size) {
+  void *block = countedAllocate(size);
+  if (block == nullptr) throw bad_alloc();
+  return block;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+  try {
+    return countedAllocate(size);
+  } catch (...) {
+    // The new handler may throw bad_alloc.
+    return nullptr;
+  }
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept {
+  try {
+    return countedAllocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *block) noexcept { countedFree(block); }
+
+void operator delete[](void *block) noexcept { countedFree(block); }
+
+void operator delete(void *block, size_t) noexcept { countedFree(block); }
+
+void operator delete[](void *block, size_t) noexcept { countedFree(block); }
+
+void operator delete(void *block, const nothrow_t &) noexcept {
+  countedFree(block);
+}
+
+void operator delete[](void *block, const nothrow_t &) noexcept {
+  countedFree(block);
+}
+
+#else
+
+AllocCounts threadAllocCounts() { return AllocCounts(); }
+
+#endif  // ALLOC_STATS
+
+AllocCounts operator-(const AllocCounts &a, const AllocCounts &b) {
+  AllocCounts difference;
+  difference.allocations = a.allocations - b.allocations;
+  difference.frees = a.frees - b.frees;
+  difference.bytes = a.bytes - b.bytes;
+  return difference;
+}
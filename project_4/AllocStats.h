@@ -0,0 +1,26 @@
+#ifndef ALLOCSTATS_INCLUDED
+#define ALLOCSTATS_INCLUDED
+
+#include "provided.h"
+
+// Allocations made by this thread since it started. Built with ALLOC_STATS
+// defined, AllocStats.cpp replaces the global operator new and delete with
+// versions that count every call in the calling thread before handing it to
+// malloc or free. Otherwise nothing is counted, and this is always zero.
+AllocCounts threadAllocCounts();
+
+AllocCounts operator-(const AllocCounts &a, const AllocCounts &b);
+
+// Counts the allocations this thread makes from its construction on, so that
+// a phase of work can be measured by putting one around it.
+class AllocScope {
+ public:
+  AllocScope() : start_(threadAllocCounts()) {}
+
+  AllocCounts counts() const { return threadAllocCounts() - start_; }
+
+ private:
+  AllocCounts start_;
+};
+
+#endif  // ALLOCSTATS_INCLUDED
@@ -1,7 +1,9 @@
 #include "provided.h"
 #include "MyMap.h"
+#include "NameIndex.h"
 
 #include <string>
+#include <vector>
 using namespace std;
 
 class AttractionMapperImpl {
@@ -9,12 +11,17 @@ class AttractionMapperImpl {
   AttractionMapperImpl();
   ~AttractionMapperImpl();
   void init(const MapLoader &ml);
-  bool getGeoCoord(string attraction, GeoCoord &gc) const;
+  void addAttraction(const Attraction &attraction);
+  bool getGeoCoord(const string &attraction, GeoCoord &gc) const;
 
  private:
   string toLower(string input) const;
 
-  MyMap<string, GeoCoord> attraction_map_;
+  // The attractions of the map never change after init, so they are found
+  // through a perfect hash. Only attractions added after init go in the tree.
+  NameIndex index_;
+  vector<GeoCoord> coords_;  // By position in the index.
+  MyMap<string, GeoCoord> added_;
 };
 
 AttractionMapperImpl::AttractionMapperImpl() {}
@@ -22,28 +29,66 @@ AttractionMapperImpl::AttractionMapperImpl() {}
 AttractionMapperImpl::~AttractionMapperImpl() {}
 
 void AttractionMapperImpl::init(const MapLoader &ml) {
+  vector<string> names;
+  vector<GeoCoord> coords;
+  MyMap<string, int> ids;  // Case-insensitive.
+
   // Travel through all segments in the map.
   for (int i = 0; i < ml.getNumSegments(); i++) {
     StreetSegment current_segment;
     if (!ml.getSegment(i, current_segment))
       cerr << "Street DNE @ num " << i << endl;
 
-    // Associate all attraction names for the current street segment with the
-    // geocoord that they came from.
+    // Collect all attraction names for the current street segment with the
+    // geocoord that they came from. A name that comes up again takes the
+    // latest geocoord.
     for (int i = 0; i < current_segment.attractions.size(); i++) {
-      attraction_map_.associate(
-          toLower(current_segment.attractions.at(i).name),  // Case-insensitive.
-          current_segment.attractions.at(i).geocoordinates);
+      const Attraction &attraction = current_segment.attractions.at(i);
+      string name = toLower(attraction.name);
+
+      int id = ids.findOrInsert(name, names.size());
+      if (id != names.size()) {
+        coords.at(id) = attraction.geocoordinates;
+        continue;
+      }
+
+      names.push_back(attraction.name);
+      coords.push_back(attraction.geocoordinates);
     }
   }
+
+  // The names were made distinct above, so this only fails if that is wrong.
+  coords_.clear();
+  if (!index_.build(names)) {
+    cerr << "Error: Attraction names must be distinct ignoring case!" << endl;
+    return;
+  }
+  coords_.resize(coords.size());
+  for (int i = 0; i < coords.size(); i++)
+    coords_.at(index_.getPosition(i)) = coords.at(i);
+}
+
+void AttractionMapperImpl::addAttraction(const Attraction &attraction) {
+  added_.associate(toLower(attraction.name), attraction.geocoordinates);
 }
 
-bool AttractionMapperImpl::getGeoCoord(string attraction, GeoCoord &gc) const {
-  // Perform a case-insensitive search for the geocoord in the tree.
-  const GeoCoord *geo_coord = attraction_map_.find(toLower(attraction));
-  if(geo_coord == nullptr) return false;  // Geocoord not found
+bool AttractionMapperImpl::getGeoCoord(const string &attraction,
+                                       GeoCoord &gc) const {
+  // Attractions added after init take precedence. Looking them up needs a
+  // lowercase copy of the name, so the tree is skipped while it is empty.
+  if (added_.size() > 0) {
+    const GeoCoord *geo_coord = added_.find(toLower(attraction));
+    if (geo_coord != nullptr) {
+      gc = *geo_coord;
+      return true;
+    }
+  }
+
+  // Perform a case-insensitive search for the geocoord in the index.
+  int position = index_.find(attraction);
+  if (position < 0) return false;  // Geocoord not found
 
-  gc = *geo_coord;  // Pass back the geocoord.
+  gc = coords_.at(position);  // Pass back the geocoord.
   return true;
 }
 
@@ -68,6 +113,11 @@ AttractionMapper::~AttractionMapper() { delete m_impl; }
 
 void AttractionMapper::init(const MapLoader &ml) { m_impl->init(ml); }
 
-bool AttractionMapper::getGeoCoord(string attraction, GeoCoord &gc) const {
+void AttractionMapper::addAttraction(const Attraction &attraction) {
+  m_impl->addAttraction(attraction);
+}
+
+bool AttractionMapper::getGeoCoord(const string &attraction,
+                                   GeoCoord &gc) const {
   return m_impl->getGeoCoord(attraction, gc);
 }
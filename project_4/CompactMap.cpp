@@ -0,0 +1,335 @@
+#include "CompactMap.h"
+#include "MyMap.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+
+static const double kFixedPointScale = 1e7;
+static const size_t kBufferSize = 1 << 16;
+
+// Fewest bytes that an encoded item can take: a name is at least its length
+// varint, an attraction its name and two coordinate varints, and a segment
+// its street name, four coordinate varints and attraction count.
+static const uint64_t kMinNameBytes = 1;
+static const uint64_t kMinAttractionBytes = 3;
+static const uint64_t kMinSegmentBytes = 6;
+
+// Parse coordinate text with exactly seven decimals into fixed point. Returns
+// false for any other form, which could not be written back identically.
+static bool textToFixedPoint(const string &text, int64_t &value) {
+  size_t i = 0;
+  bool negative = i < text.size() && text[i] == '-';
+  if (negative) i++;
+
+  size_t dot = text.find('.', i);
+  if (dot == string::npos || dot == i || text.size() - dot - 1 != 7)
+    return false;
+
+  value = 0;
+  for (; i < text.size(); i++) {
+    if (i == dot) continue;
+    if (text[i] < '0' || text[i] > '9') return false;
+    value = value * 10 + (text[i] - '0');
+  }
+
+  if (negative) value = -value;
+  return true;
+}
+
+// Inverse of textToFixedPoint.
+static void fixedPointToText(int64_t value, string &text) {
+  char digits[24];
+  char *end = digits + sizeof(digits), *p = end;
+  uint64_t magnitude = value < 0 ? -static_cast<uint64_t>(value) : value;
+
+  for (int i = 0; i < 7; i++) {
+    *--p = '0' + magnitude % 10;
+    magnitude /= 10;
+  }
+  *--p = '.';
+  do {
+    *--p = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0) *--p = '-';
+
+  text.assign(p, end);
+}
+
+static void writeVarint(uint64_t value, string &out) {
+  while (value >= 0x80) {
+    out += static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+static uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ (value < 0 ? ~0ULL : 0);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Write a coordinate relative to the last one written, and make it the last.
+static bool writeCoord(const GeoCoord &gc, int64_t &latitude,
+                       int64_t &longitude, string &out) {
+  int64_t next_latitude, next_longitude;
+  if (!textToFixedPoint(gc.latitudeText, next_latitude) ||
+      !textToFixedPoint(gc.longitudeText, next_longitude))
+    return false;
+
+  writeVarint(zigzag(next_latitude - latitude), out);
+  writeVarint(zigzag(next_longitude - longitude), out);
+  latitude = next_latitude;
+  longitude = next_longitude;
+  return true;
+}
+
+bool isCompactMap(const string &mapFile) {
+  ifstream in(mapFile, ios::binary);
+  char magic[kCompactMapMagicLength];
+
+  return in.read(magic, kCompactMapMagicLength) &&
+         memcmp(magic, kCompactMapMagic, kCompactMapMagicLength) == 0;
+}
+
+bool writeCompactMap(const MapLoader &ml, const string &mapFile) {
+  vector<StreetSegment> segments(ml.getNumSegments());
+  for (int i = 0; i < segments.size(); i++) ml.getSegment(i, segments[i]);
+
+  string out;
+  if (!encodeCompactMap(segments, out)) return false;
+
+  ofstream file(mapFile, ios::binary);
+  return file.write(out.data(), out.size()) && file.flush();
+}
+
+bool encodeCompactMap(const vector<StreetSegment> &segments, string &out) {
+  // Number the names in order of first use.
+  MyMap<string, int> name_ids;
+  vector<const string *> names;
+  for (int i = 0; i < segments.size(); i++) {
+    vector<const string *> used(1, &segments[i].streetName);
+    for (int j = 0; j < segments[i].attractions.size(); j++)
+      used.push_back(&segments[i].attractions[j].name);
+
+    for (int j = 0; j < used.size(); j++) {
+      if (name_ids.findOrInsert(*used[j], names.size()) == names.size())
+        names.push_back(used[j]);
+    }
+  }
+
+  out.append(kCompactMapMagic, kCompactMapMagicLength);
+  writeVarint(names.size(), out);
+  for (int i = 0; i < names.size(); i++) {
+    writeVarint(names[i]->size(), out);
+    out += *names[i];
+  }
+
+  writeVarint(segments.size(), out);
+  int64_t latitude = 0, longitude = 0;
+  for (int i = 0; i < segments.size(); i++) {
+    const StreetSegment &segment = segments[i];
+    writeVarint(*name_ids.find(segment.streetName), out);
+
+    if (!writeCoord(segment.segment.start, latitude, longitude, out))
+      return false;
+    int64_t start_latitude = latitude, start_longitude = longitude;
+    if (!writeCoord(segment.segment.end, latitude, longitude, out))
+      return false;
+    int64_t end_latitude = latitude, end_longitude = longitude;
+
+    writeVarint(segment.attractions.size(), out);
+    for (int j = 0; j < segment.attractions.size(); j++) {
+      writeVarint(*name_ids.find(segment.attractions[j].name), out);
+
+      latitude = start_latitude;
+      longitude = start_longitude;
+      if (!writeCoord(segment.attractions[j].geocoordinates, latitude,
+                      longitude, out))
+        return false;
+    }
+
+    latitude = end_latitude;
+    longitude = end_longitude;
+  }
+
+  return true;
+}
+
+CompactMapReader::CompactMapReader()
+    : buffer_(kBufferSize),
+      buffer_pos_(0),
+      buffer_size_(0),
+      file_left_(0),
+      segments_left_(0),
+      num_segments_(0),
+      latitude_(0),
+      longitude_(0),
+      failed_(false) {}
+
+bool CompactMapReader::open(const string &mapFile, uint64_t offset) {
+  in_.close();
+  in_.clear();
+  in_.open(mapFile, ios::binary);
+  in_.seekg(0, ios::end);
+  uint64_t file_size = in_ ? static_cast<uint64_t>(in_.tellg()) : 0;
+  in_.seekg(offset);
+  buffer_pos_ = buffer_size_ = 0;
+  file_left_ = offset < file_size ? file_size - offset : 0;
+  names_.clear();
+  segments_left_ = num_segments_ = 0;
+  latitude_ = longitude_ = 0;
+  failed_ = !in_;
+
+  char magic[kCompactMapMagicLength];
+  for (int i = 0; i < kCompactMapMagicLength; i++) {
+    uint8_t byte;
+    if (!readByte(byte)) return false;
+    magic[i] = byte;
+  }
+  if (memcmp(magic, kCompactMapMagic, kCompactMapMagicLength) != 0)
+    return false;
+
+  uint64_t num_names;
+  if (!readVarint(num_names) || !checkCount(num_names, kMinNameBytes))
+    return false;
+  names_.resize(num_names);
+  for (int i = 0; i < num_names; i++) {
+    uint64_t length;
+    if (!readVarint(length) || !checkCount(length, 1)) return false;
+
+    // Copy names straight out of the buffer, a buffer at a time.
+    string &name = names_[i];
+    name.reserve(length);
+    while (name.size() < length) {
+      if (buffer_pos_ == buffer_size_) {
+        uint8_t byte;
+        if (!readByte(byte)) return false;
+        name += static_cast<char>(byte);
+        continue;
+      }
+
+      size_t count = min<size_t>(length - name.size(),
+                                 buffer_size_ - buffer_pos_);
+      name.append(buffer_.data() + buffer_pos_, count);
+      buffer_pos_ += count;
+    }
+  }
+
+  uint64_t num_segments;
+  if (!readVarint(num_segments) ||
+      !checkCount(num_segments, kMinSegmentBytes))
+    return false;
+  segments_left_ = num_segments_ = num_segments;
+  return true;
+}
+
+size_t CompactMapReader::getNumSegments() const { return num_segments_; }
+
+bool CompactMapReader::next(StreetSegment &seg) {
+  if (segments_left_ == 0 || failed_) return false;
+
+  const string *street_name;
+  if (!readName(street_name)) return false;
+  seg.streetName = *street_name;
+
+  if (!readCoord(latitude_, longitude_, seg.segment.start)) return false;
+  int64_t start_latitude = latitude_, start_longitude = longitude_;
+  if (!readCoord(latitude_, longitude_, seg.segment.end)) return false;
+
+  uint64_t num_attractions;
+  if (!readVarint(num_attractions) ||
+      !checkCount(num_attractions, kMinAttractionBytes))
+    return false;
+  seg.attractions.resize(num_attractions);
+  for (int i = 0; i < num_attractions; i++) {
+    const string *name;
+    if (!readName(name)) return false;
+    seg.attractions[i].name = *name;
+
+    int64_t latitude = start_latitude, longitude = start_longitude;
+    if (!readCoord(latitude, longitude, seg.attractions[i].geocoordinates))
+      return false;
+  }
+
+  segments_left_--;
+  return true;
+}
+
+bool CompactMapReader::readByte(uint8_t &byte) {
+  if (buffer_pos_ == buffer_size_) {
+    in_.read(buffer_.data(), buffer_.size());
+    buffer_size_ = in_.gcount();
+    buffer_pos_ = 0;
+    file_left_ -= min<uint64_t>(file_left_, buffer_size_);
+
+    if (buffer_size_ == 0) {
+      failed_ = true;
+      return false;
+    }
+  }
+
+  byte = buffer_[buffer_pos_++];
+  return true;
+}
+
+uint64_t CompactMapReader::bytesLeft() const {
+  return file_left_ + (buffer_size_ - buffer_pos_);
+}
+
+bool CompactMapReader::checkCount(uint64_t count, uint64_t min_item_bytes) {
+  if (count <= bytesLeft() / min_item_bytes) return true;
+
+  failed_ = true;
+  return false;
+}
+
+bool CompactMapReader::readVarint(uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte;
+    if (!readByte(byte)) return false;
+
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+
+  failed_ = true;
+  return false;
+}
+
+bool CompactMapReader::readName(const string *&name) {
+  uint64_t id;
+  if (!readVarint(id)) return false;
+  if (id >= names_.size()) {
+    failed_ = true;
+    return false;
+  }
+
+  name = &names_[id];
+  return true;
+}
+
+bool CompactMapReader::readCoord(int64_t &latitude, int64_t &longitude,
+                                 GeoCoord &gc) {
+  uint64_t latitude_delta, longitude_delta;
+  if (!readVarint(latitude_delta) || !readVarint(longitude_delta))
+    return false;
+
+  latitude += unzigzag(latitude_delta);
+  longitude += unzigzag(longitude_delta);
+
+  // Dividing by a power of ten is correctly rounded, so this gives exactly
+  // the same doubles as parsing the text would.
+  fixedPointToText(latitude, gc.latitudeText);
+  fixedPointToText(longitude, gc.longitudeText);
+  gc.latitude = latitude / kFixedPointScale;
+  gc.longitude = longitude / kFixedPointScale;
+  return true;
+}
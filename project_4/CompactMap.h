@@ -0,0 +1,91 @@
+#ifndef COMPACTMAP_INCLUDED
+#define COMPACTMAP_INCLUDED
+
+#include "provided.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Compact binary form of a map file, which MapLoader reads in place of the
+// text form whenever a file starts with the magic bytes below.
+//
+// Coordinates are stored as fixed-point numbers of ten-millionths of a
+// degree, the precision of the text map, and every coordinate is stored as
+// the difference from the one before it: a segment's start from the previous
+// segment's end, its end from its start, and its attractions from its start.
+// Consecutive segments of a street share endpoints, so most differences are
+// zero or tiny. Street and attraction names are stored once each in a
+// dictionary and referred to by number. All numbers are LEB128 varints, and
+// signed ones are zigzag encoded first.
+//
+//  magic          "BNM1"
+//  name count     varint, followed by that many (length varint, bytes)
+//  segment count  varint, followed by that many segments of
+//    street name      varint
+//    start, end       two signed varints each (latitude, longitude)
+//    attractions      varint, followed by that many (name varint, coordinate)
+const char kCompactMapMagic[] = "BNM1";
+const int kCompactMapMagicLength = 4;
+
+// Whether the file is a compact map.
+bool isCompactMap(const std::string &mapFile);
+
+// Write the segments of a loaded map as a compact map. Fails if the file
+// cannot be written, or if some coordinate is not written with exactly seven
+// decimals in the text map and so would not come back identical.
+bool writeCompactMap(const MapLoader &ml, const std::string &mapFile);
+// Encode the given segments as a compact map in memory, appending it to out.
+// Fails under the same conditions as writeCompactMap.
+bool encodeCompactMap(const std::vector<StreetSegment> &segments,
+                      std::string &out);
+
+// Streaming decoder for compact maps, which reads the file through a fixed
+// buffer and hands out one segment at a time.
+class CompactMapReader {
+ public:
+  CompactMapReader();
+
+  // Open a compact map that starts the given number of bytes into a file, and
+  // read its name dictionary. Returns false if the file is cut short or
+  // corrupt, including when it claims more names or segments than the rest
+  // of the file could hold.
+  bool open(const std::string &mapFile, uint64_t offset = 0);
+  size_t getNumSegments() const;
+  // Decode the next segment into seg. Returns false once every segment has
+  // been read, or if the file is cut short or corrupt.
+  bool next(StreetSegment &seg);
+
+  // We prevent a CompactMapReader object from being copied or assigned.
+  CompactMapReader(const CompactMapReader &) = delete;
+  CompactMapReader &operator=(const CompactMapReader &) = delete;
+
+ private:
+  bool readByte(uint8_t &byte);
+  // Bytes of the file from the read position on, which bound how many items
+  // a count read from the file can honestly claim.
+  uint64_t bytesLeft() const;
+  // Check a count read from the file against the bytes left, given the
+  // fewest bytes each item takes, and mark the reader failed if it cannot
+  // fit. This keeps corrupt counts from sizing containers.
+  bool checkCount(uint64_t count, uint64_t min_item_bytes);
+  bool readVarint(uint64_t &value);
+  bool readName(const std::string *&name);
+  // Read a coordinate stored relative to the given one.
+  bool readCoord(int64_t &latitude, int64_t &longitude, GeoCoord &gc);
+
+  std::ifstream in_;
+  std::vector<char> buffer_;
+  size_t buffer_pos_;
+  size_t buffer_size_;
+  uint64_t file_left_;  // Bytes of the file not yet read into the buffer.
+  std::vector<std::string> names_;
+  size_t segments_left_;
+  size_t num_segments_;
+  int64_t latitude_;   // Last segment end, in ten-millionths of a degree.
+  int64_t longitude_;
+  bool failed_;
+};
+
+#endif  // COMPACTMAP_INCLUDED
@@ -0,0 +1,90 @@
+#include "Directions.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Compass direction for a bearing in degrees counterclockwise from east.
+static const char *proceedDirection(double angle) {
+  // Each direction covers the 45 degrees up to and including its upper edge.
+  static const double kUpperEdges[] = {22.5,  67.5,  112.5, 157.5,
+                                       202.5, 247.5, 292.5, 337.5};
+  static const char *const kDirections[] = {
+      "east", "northeast", "north", "northwest",
+      "west", "southwest", "south", "southeast"};
+
+  angle = fmod(angle, 360.0);
+  if (angle < 0 || angle >= 360) return "INVALID";
+
+  for (int i = 0; i < 8; i++) {
+    if (angle <= kUpperEdges[i]) return kDirections[i];
+  }
+  return "east";
+}
+
+// Direction of a turn, given the change in bearing from the street being left
+// to the street being turned onto.
+static const char *turnDirection(double angle) {
+  if (angle < 0 || angle >= 360) return "INVALID";
+  return angle < 180 ? "left" : "right";
+}
+
+void makeDirections(const vector<NavSegment> &legs, bool compact,
+                    vector<NavSegment> &directions) {
+  directions.clear();
+  if (legs.empty()) return;
+
+  // Size the output up front: a turn goes in at every change of street, and
+  // in compact mode each street is left with a single proceed.
+  int turns = 0;
+  for (int i = 1; i < legs.size(); i++) {
+    if (legs[i].m_streetName != legs[i - 1].m_streetName) turns++;
+  }
+  directions.reserve(compact ? 2 * turns + 1 : legs.size() + turns);
+
+  // In compact mode, a proceed that legs were merged into heads along the
+  // chord of the merged legs, which is only worked out once it is complete.
+  bool merged = false;
+  auto finishMerge = [&directions, &merged]() {
+    if (!merged) return;
+    NavSegment &proceed = directions.back();
+    proceed.m_direction = proceedDirection(angleOfLine(proceed.m_geoSegment));
+    merged = false;
+  };
+
+  double previous_bearing = 0;
+  for (int i = 0; i < legs.size(); i++) {
+    const NavSegment &leg = legs[i];
+    double bearing = angleOfLine(leg.m_geoSegment);
+    bool same_street = i > 0 && leg.m_streetName == legs[i - 1].m_streetName;
+
+    if (i > 0 && !same_street) {
+      finishMerge();
+      double turn = bearing - previous_bearing;
+      if (turn < 0) turn += 360;
+      directions.push_back(NavSegment(turnDirection(turn), leg.m_streetName));
+    }
+    previous_bearing = bearing;
+
+    if (compact && same_street) {
+      // Stretch the proceed for this street to the end of this leg.
+      NavSegment &proceed = directions.back();
+      proceed.m_geoSegment.end = leg.m_geoSegment.end;
+      proceed.m_distance += leg.m_distance;
+      merged = true;
+      continue;
+    }
+
+    directions.push_back(leg);
+    NavSegment &proceed = directions.back();
+    proceed.m_direction = proceedDirection(bearing);
+
+    // The first leg is measured from its geo segment, whatever it was given.
+    if (i == 0) {
+      proceed.m_distance = distanceEarthMiles(leg.m_geoSegment.start,
+                                              leg.m_geoSegment.end);
+    }
+  }
+  finishMerge();
+}
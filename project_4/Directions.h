@@ -0,0 +1,21 @@
+#ifndef DIRECTIONS_INCLUDED
+#define DIRECTIONS_INCLUDED
+
+#include "provided.h"
+
+#include <vector>
+
+// Turn the legs of a route, given as proceed segments that only have their
+// street name, distance and geo segment filled in, into directions: every leg
+// gets the compass direction it heads in, and a turn is put in wherever the
+// street changes. In compact mode, consecutive legs on the same street are
+// merged into a single proceed that heads from the start of the first to the
+// end of the last.
+//
+// The directions are written in a single pass over the legs, into a vector
+// that is sized for them up front, and every leg's bearing is only worked out
+// once.
+void makeDirections(const std::vector<NavSegment> &legs, bool compact,
+                    std::vector<NavSegment> &directions);
+
+#endif  // DIRECTIONS_INCLUDED
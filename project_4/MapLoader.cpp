@@ -1,4 +1,5 @@
 #include "provided.h"
+#include "CompactMap.h"
 #include "MyMap.h"
 
 #include <string>
@@ -15,6 +16,7 @@ class MapLoaderImpl {
   bool getSegment(size_t segNum, StreetSegment &seg) const;
 
  private:
+  bool loadCompact(string mapFile);
   vector<GeoCoord> findCoords(string text);
 
   vector<StreetSegment> street_segments_;
@@ -25,6 +27,8 @@ MapLoaderImpl::MapLoaderImpl() {}
 MapLoaderImpl::~MapLoaderImpl() {}
 
 bool MapLoaderImpl::load(string mapFile) {
+  if (isCompactMap(mapFile)) return loadCompact(mapFile);
+
   ifstream in(mapFile);
   if (!in) {
     cerr << "Error: Cannot open data.txt!" << endl;
@@ -105,6 +109,27 @@ bool MapLoaderImpl::load(string mapFile) {
   return true;
 }
 
+bool MapLoaderImpl::loadCompact(string mapFile) {
+  CompactMapReader reader;
+  if (!reader.open(mapFile)) {
+    cerr << "Error: Cannot read compact map " << mapFile << "!" << endl;
+    return false;
+  }
+
+  // Decode straight into the segment list, which is sized up front.
+  size_t first = street_segments_.size();
+  street_segments_.resize(first + reader.getNumSegments());
+  for (size_t i = first; i < street_segments_.size(); i++) {
+    if (!reader.next(street_segments_[i])) {
+      cerr << "Error: Compact map " << mapFile << " is corrupt!" << endl;
+      street_segments_.resize(first);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 size_t MapLoaderImpl::getNumSegments() const { return street_segments_.size(); }
 
 bool MapLoaderImpl::getSegment(size_t segNum, StreetSegment &seg) const {
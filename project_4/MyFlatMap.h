@@ -0,0 +1,177 @@
+#ifndef MYFLATMAP_INCLUDED
+#define MYFLATMAP_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Read-mostly sibling of MyMap, for indexes that are filled once and then
+// only searched. Entries are staged with associate, and only become visible
+// to find once freeze has sorted them and laid them out for searching.
+//
+// Keys and values are kept in two arrays, with no per-entry pointers, in
+// Eytzinger order: the root of an implicit balanced search tree is at index
+// 1, and the children of the entry at index i are at 2i and 2i + 1. A search
+// is then a walk down the array that picks the next index arithmetically
+// instead of branching, and the entries a few levels down are contiguous, so
+// they can be fetched into the cache before they are reached.
+template <typename KeyType, typename ValueType>
+class MyFlatMap {
+ public:
+  MyFlatMap();
+  // Build the map from a range of key/value pairs in one go, as assign does.
+  template <typename InputIterator>
+  MyFlatMap(InputIterator first, InputIterator last);
+  void clear();
+  // Number of entries that find can see, which does not count entries
+  // staged since the last freeze.
+  int size() const;
+  // Stage an entry for the next freeze. Of entries with equal keys, the one
+  // staged last wins.
+  void associate(const KeyType &key, const ValueType &value);
+  // Merge the staged entries into the map and lay it out for searching.
+  void freeze();
+  // Replace the contents with a range of key/value pairs, and freeze.
+  template <typename InputIterator>
+  void assign(InputIterator first, InputIterator last);
+
+  const ValueType *find(const KeyType &key) const;
+  ValueType *find(const KeyType &key) {
+    return const_cast<ValueType *>(
+        const_cast<const MyFlatMap *>(this)->find(key));
+  }
+
+  // We prevent a MyFlatMap object from being copied or assigned.
+  MyFlatMap(const MyFlatMap &) = delete;
+  MyFlatMap &operator=(const MyFlatMap &) = delete;
+
+ private:
+  // Lay sorted entries out in the subtree rooted at the given slot, starting
+  // with sorted[next], and return the index of the entry to take after them.
+  size_t layOut(std::vector<std::pair<KeyType, ValueType>> &sorted,
+                size_t next, size_t slot);
+
+  std::vector<KeyType> keys_;      // Eytzinger order, with index 0 unused.
+  std::vector<ValueType> values_;  // Same order as keys_.
+  std::vector<std::pair<KeyType, ValueType>> staged_;
+};
+
+template <typename KeyType, typename ValueType>
+MyFlatMap<KeyType, ValueType>::MyFlatMap() {}
+
+template <typename KeyType, typename ValueType>
+template <typename InputIterator>
+MyFlatMap<KeyType, ValueType>::MyFlatMap(InputIterator first,
+                                         InputIterator last) {
+  assign(first, last);
+}
+
+template <typename KeyType, typename ValueType>
+void MyFlatMap<KeyType, ValueType>::clear() {
+  // Swap the arrays away so that their memory is given back.
+  std::vector<KeyType>().swap(keys_);
+  std::vector<ValueType>().swap(values_);
+  std::vector<std::pair<KeyType, ValueType>>().swap(staged_);
+}
+
+template <typename KeyType, typename ValueType>
+int MyFlatMap<KeyType, ValueType>::size() const {
+  return keys_.empty() ? 0 : keys_.size() - 1;
+}
+
+template <typename KeyType, typename ValueType>
+void MyFlatMap<KeyType, ValueType>::associate(const KeyType &key,
+                                              const ValueType &value) {
+  staged_.push_back(std::make_pair(key, value));
+}
+
+template <typename KeyType, typename ValueType>
+void MyFlatMap<KeyType, ValueType>::freeze() {
+  if (staged_.empty()) return;
+
+  // Entries already in the map come first, so that staged entries replace
+  // them.
+  std::vector<std::pair<KeyType, ValueType>> sorted;
+  sorted.reserve(size() + staged_.size());
+  for (size_t i = 1; i < keys_.size(); i++) {
+    sorted.push_back(
+        std::make_pair(std::move(keys_[i]), std::move(values_[i])));
+  }
+  for (size_t i = 0; i < staged_.size(); i++)
+    sorted.push_back(std::move(staged_[i]));
+  std::vector<std::pair<KeyType, ValueType>>().swap(staged_);
+
+  // Sort by key, keeping equal keys in the order they were given, and keep
+  // only the last of each run of equal keys.
+  auto less = [](const std::pair<KeyType, ValueType> &a,
+                 const std::pair<KeyType, ValueType> &b) {
+    return a.first < b.first;
+  };
+  if (!std::is_sorted(sorted.begin(), sorted.end(), less))
+    std::stable_sort(sorted.begin(), sorted.end(), less);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    if (i + 1 < sorted.size() && !(sorted[i].first < sorted[i + 1].first))
+      continue;
+    if (kept != i) sorted[kept] = std::move(sorted[i]);
+    kept++;
+  }
+  sorted.erase(sorted.begin() + kept, sorted.end());
+
+  // An in-order walk of the implicit tree visits the slots in key order.
+  keys_.assign(sorted.size() + 1, KeyType());
+  values_.assign(sorted.size() + 1, ValueType());
+  layOut(sorted, 0, 1);
+}
+
+template <typename KeyType, typename ValueType>
+template <typename InputIterator>
+void MyFlatMap<KeyType, ValueType>::assign(InputIterator first,
+                                           InputIterator last) {
+  clear();
+  staged_.assign(first, last);
+  freeze();
+}
+
+template <typename KeyType, typename ValueType>
+const ValueType *MyFlatMap<KeyType, ValueType>::find(
+    const KeyType &key) const {
+  size_t n = size();
+  if (n == 0) return nullptr;
+
+  // Go down the tree until falling off the bottom, fetching the entries four
+  // levels down along the way. Each step goes to the right child exactly
+  // when the entry is less than the key.
+  const KeyType *keys = keys_.data();
+  size_t i = 1;
+  while (i <= n) {
+#if defined(__GNUC__)
+    if (16 * i <= n) __builtin_prefetch(keys + 16 * i);
+#endif
+    i = 2 * i + (keys[i] < key);
+  }
+
+  // The last step to the left was taken from the least entry that is not
+  // less than the key. Undo every step to the right after it, then it.
+  while (i & 1) i >>= 1;
+  i >>= 1;
+
+  if (i == 0 || !(keys[i] == key)) return nullptr;
+  return &values_[i];
+}
+
+template <typename KeyType, typename ValueType>
+size_t MyFlatMap<KeyType, ValueType>::layOut(
+    std::vector<std::pair<KeyType, ValueType>> &sorted, size_t next,
+    size_t slot) {
+  if (slot >= keys_.size()) return next;
+
+  next = layOut(sorted, next, 2 * slot);
+  keys_[slot] = std::move(sorted[next].first);
+  values_[slot] = std::move(sorted[next].second);
+  return layOut(sorted, next + 1, 2 * slot + 1);
+}
+
+#endif  // MYFLATMAP_INCLUDED
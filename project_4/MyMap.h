@@ -1,16 +1,91 @@
 #ifndef MYMAP_INCLUDED
 #define MYMAP_INCLUDED
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 template <typename KeyType, typename ValueType>
 class MyMap {
+ private:
+  struct Node;
+
+  // In-order iterator over the tree, which keeps the path of nodes still to
+  // be visited on the way back up, so that nodes need no parent pointers.
+  template <typename EntryType, typename NodeType>
+  class Iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef EntryType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef EntryType *pointer;
+    typedef EntryType &reference;
+
+    Iterator() {}
+    explicit Iterator(NodeType *tree) { descend(tree); }
+    // Iterators convert to const iterators.
+    template <typename OtherEntryType, typename OtherNodeType>
+    Iterator(const Iterator<OtherEntryType, OtherNodeType> &other)
+        : path_(other.path_.begin(), other.path_.end()) {}
+
+    reference operator*() const { return path_.back()->entry; }
+    pointer operator->() const { return &path_.back()->entry; }
+
+    Iterator &operator++() {
+      NodeType *node = path_.back();
+      path_.pop_back();
+      descend(node->more);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return path_.empty() ? other.path_.empty()
+                           : !other.path_.empty() &&
+                                 path_.back() == other.path_.back();
+    }
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+   private:
+    // Go down to the least node of a subtree, noting the way back up.
+    void descend(NodeType *tree) {
+      for (; tree != nullptr; tree = tree->less) path_.push_back(tree);
+    }
+
+    template <typename, typename>
+    friend class Iterator;
+
+    std::vector<NodeType *> path_;
+  };
+
  public:
+  typedef std::pair<const KeyType, ValueType> value_type;
+  typedef Iterator<value_type, Node> iterator;
+  typedef Iterator<const value_type, const Node> const_iterator;
+
   MyMap();
+  // Build a perfectly balanced tree from a range of key/value pairs in one
+  // go (see assign).
+  template <typename InputIterator>
+  MyMap(InputIterator first, InputIterator last);
   ~MyMap();
   void clear();
   int size() const;
   void associate(const KeyType &key, const ValueType &value);
+  // Replace the contents with a range of key/value pairs. The pairs are
+  // sorted unless they already are in order, and then laid out as a
+  // perfectly balanced tree in a single pass. Of pairs with equal keys, the
+  // last one given wins, as if they had been associated in order.
+  template <typename InputIterator>
+  void assign(InputIterator first, InputIterator last);
 
   // for a map that can't be modified, return a pointer to const ValueType
   const ValueType *find(const KeyType &key) const;
@@ -20,14 +95,24 @@ class MyMap {
     return const_cast<ValueType *>(const_cast<const MyMap *>(this)->find(key));
   }
 
+  // Return the value associated with key, first associating a copy of value
+  // with it if there is none. Takes a single trip down the tree either way.
+  ValueType &findOrInsert(const KeyType &key,
+                          const ValueType &value = ValueType());
+
+  // Iterate over the entries in order of their keys.
+  iterator begin() { return iterator(tree_); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(tree_); }
+  const_iterator end() const { return const_iterator(); }
+
   // C++11 syntax for preventing copying and assignment
   MyMap(const MyMap &) = delete;
   MyMap &operator=(const MyMap &) = delete;
 
  private:
   struct Node {
-    KeyType key;
-    ValueType value;
+    value_type entry;
     Node *less;
     Node *more;
   };
@@ -35,6 +120,10 @@ class MyMap {
   void deleteTree(Node *tree);
   void insert(Node *tree, const KeyType &key, const ValueType &value);
   ValueType *locate(Node *tree, const KeyType &key) const;
+  // Build a balanced tree out of entries [begin, end), which are sorted and
+  // have distinct keys.
+  Node *buildTree(std::vector<std::pair<KeyType, ValueType>> &entries,
+                  size_t begin, size_t end);
 
   Node *tree_;
   int size_;
@@ -45,6 +134,13 @@ template <typename KeyType, typename ValueType>
 MyMap<KeyType, ValueType>::MyMap()
     : tree_(nullptr), size_(0) {}
 
+template <typename KeyType, typename ValueType>
+template <typename InputIterator>
+MyMap<KeyType, ValueType>::MyMap(InputIterator first, InputIterator last)
+    : tree_(nullptr), size_(0) {
+  assign(first, last);
+}
+
 template <typename KeyType, typename ValueType>
 MyMap<KeyType, ValueType>::~MyMap() {
   clear();
@@ -69,7 +165,7 @@ void MyMap<KeyType, ValueType>::associate(const KeyType &key,
                                           const ValueType &value) {
   // Initialize the tree, if not already done so.
   if (tree_ == nullptr) {
-    tree_ = new Node({key, value, nullptr, nullptr});
+    tree_ = new Node{value_type(key, value), nullptr, nullptr};
     size_++;
     return;
   }
@@ -78,6 +174,35 @@ void MyMap<KeyType, ValueType>::associate(const KeyType &key,
   insert(tree_, key, value);
 }
 
+template <typename KeyType, typename ValueType>
+template <typename InputIterator>
+void MyMap<KeyType, ValueType>::assign(InputIterator first,
+                                       InputIterator last) {
+  std::vector<std::pair<KeyType, ValueType>> entries(first, last);
+
+  // Sort by key, keeping equal keys in the order they were given.
+  auto less = [](const std::pair<KeyType, ValueType> &a,
+                 const std::pair<KeyType, ValueType> &b) {
+    return a.first < b.first;
+  };
+  if (!std::is_sorted(entries.begin(), entries.end(), less))
+    std::stable_sort(entries.begin(), entries.end(), less);
+
+  // Keep only the last of each run of equal keys.
+  size_t kept = 0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (i + 1 < entries.size() && !(entries[i].first < entries[i + 1].first))
+      continue;
+    if (kept != i) entries[kept] = std::move(entries[i]);
+    kept++;
+  }
+  entries.erase(entries.begin() + kept, entries.end());
+
+  clear();
+  tree_ = buildTree(entries, 0, entries.size());
+  size_ = entries.size();
+}
+
 template <typename KeyType, typename ValueType>
 const ValueType *MyMap<KeyType, ValueType>::find(const KeyType &key) const {
   // Don't attempt a search on an empty tree.
@@ -86,19 +211,35 @@ const ValueType *MyMap<KeyType, ValueType>::find(const KeyType &key) const {
   return locate(tree_, key);
 }
 
+template <typename KeyType, typename ValueType>
+ValueType &MyMap<KeyType, ValueType>::findOrInsert(const KeyType &key,
+                                                   const ValueType &value) {
+  // Walk down to the key, or to the empty branch where it belongs.
+  Node **branch = &tree_;
+  while (*branch != nullptr) {
+    const KeyType &branch_key = (*branch)->entry.first;
+    if (key == branch_key) return (*branch)->entry.second;
+    branch = key < branch_key ? &(*branch)->less : &(*branch)->more;
+  }
+
+  *branch = new Node{value_type(key, value), nullptr, nullptr};
+  size_++;
+  return (*branch)->entry.second;
+}
+
 template <typename KeyType, typename ValueType>
 ValueType *MyMap<KeyType, ValueType>::locate(Node *tree,
                                              const KeyType &key) const {
   // Assumes that tree already exists.
 
   // Found key at current branches, so return value.
-  if (tree->key == key) return &tree->value;
+  if (tree->entry.first == key) return &tree->entry.second;
 
   // Search the appropriate tree based on whether the key is greater than or
   // less than the current branch's value.
-  if (key < tree->key && tree->less != nullptr) {
+  if (key < tree->entry.first && tree->less != nullptr) {
     return locate(tree->less, key);
-  } else if (key > tree->key && tree->more != nullptr) {
+  } else if (key > tree->entry.first && tree->more != nullptr) {
     return locate(tree->more, key);
   }
 
@@ -114,19 +255,19 @@ void MyMap<KeyType, ValueType>::insert(Node *tree, const KeyType &key,
   // Insert the new value into the tree by traveling through branches
   // recursively until either a match is found or a greater/less than position
   // for the key is found.
-  if (key < tree->key) {
+  if (key < tree->entry.first) {
     if (tree->less == nullptr) {
       // No less-than, so insert this key into tree.
-      tree->less = new Node{key, value, nullptr, nullptr};
+      tree->less = new Node{value_type(key, value), nullptr, nullptr};
       size_++;
     } else {
       // Traverse subtree on the lesser side.
       insert(tree->less, key, value);
     }
-  } else if (key > tree->key) {
+  } else if (key > tree->entry.first) {
     if (tree->more == nullptr) {
       // No greater-than, so insert this key into tree.
-      tree->more = new Node{key, value, nullptr, nullptr};
+      tree->more = new Node{value_type(key, value), nullptr, nullptr};
       size_++;
     } else {
       // Traverse subtree on the greater side.
@@ -134,10 +275,27 @@ void MyMap<KeyType, ValueType>::insert(Node *tree, const KeyType &key,
     }
   } else {
     // Value matches, so replace value at current spot.
-    tree->value = value;
+    tree->entry.second = value;
   }
 }
 
+template <typename KeyType, typename ValueType>
+typename MyMap<KeyType, ValueType>::Node *MyMap<KeyType, ValueType>::buildTree(
+    std::vector<std::pair<KeyType, ValueType>> &entries, size_t begin,
+    size_t end) {
+  if (begin == end) return nullptr;
+
+  // The middle entry goes at the root, with the entries on either side of it
+  // split the same way below it.
+  size_t middle = begin + (end - begin) / 2;
+  Node *tree = new Node{value_type(std::move(entries[middle].first),
+                                   std::move(entries[middle].second)),
+                        nullptr, nullptr};
+  tree->less = buildTree(entries, begin, middle);
+  tree->more = buildTree(entries, middle + 1, end);
+  return tree;
+}
+
 template <typename KeyType, typename ValueType>
 void MyMap<KeyType, ValueType>::deleteTree(Node *tree) {
   // Delete tree only if it exists. (stopping condition of recursion)
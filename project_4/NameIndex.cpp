@@ -0,0 +1,158 @@
+#include "NameIndex.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Average number of names per bucket. Larger buckets make the displacement
+// table smaller but take longer to place.
+static const int kNamesPerBucket = 4;
+
+// Seeds to try before giving up on placing the buckets. Each failure has a
+// tiny chance, so running out means that two names hash identically, which
+// only happens if they are equal ignoring case.
+static const int kMaxSeeds = 64;
+
+// Multiples of a name's step to try moving a bucket by. Each multiple comes
+// with every possible offset, so this only bounds the work spent on a bucket
+// that cannot be placed with the current seed.
+static const uint32_t kMaxTimes = 256;
+
+// Lowercase a byte the way tolower does in the "C" locale, which BruinNav
+// never leaves, without a library call per byte.
+static inline unsigned char foldCase(unsigned char c) {
+  return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Finalizer from splitmix64, which spreads every input bit over the output.
+static uint64_t mix(uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+NameIndex::NameIndex() : seed_(0) {}
+
+bool NameIndex::build(const vector<string> &names) {
+  displacements_.clear();
+  names_.clear();
+  positions_.clear();
+  if (names.empty()) return true;
+
+  int num_buckets = (names.size() + kNamesPerBucket - 1) / kNamesPerBucket;
+  for (int attempt = 0; attempt < kMaxSeeds; attempt++) {
+    seed_ = mix(attempt + 1);
+    names_.assign(names.size(), "");
+    displacements_.assign(num_buckets, Displacement{0, 0});
+
+    vector<Hash> hashes(names.size());
+    for (int i = 0; i < names.size(); i++) hashes[i] = hash(names[i]);
+    if (!place(hashes)) continue;
+
+    // Lay every name out at its position.
+    positions_.resize(names.size());
+    for (int i = 0; i < names.size(); i++) {
+      positions_[i] = position(hashes[i]);
+
+      string &name = names_[positions_[i]];
+      name = names[i];
+      for (int j = 0; j < name.size(); j++)
+        name[j] = foldCase(name[j]);
+    }
+    return true;
+  }
+
+  displacements_.clear();
+  names_.clear();
+  positions_.clear();
+  return false;
+}
+
+int NameIndex::size() const { return names_.size(); }
+
+int NameIndex::find(const string &name) const {
+  if (names_.empty()) return -1;
+
+  int p = position(hash(name));
+  const string &candidate = names_[p];
+  if (candidate.size() != name.size()) return -1;
+
+  for (int i = 0; i < name.size(); i++) {
+    if (foldCase(name[i]) != static_cast<unsigned char>(candidate[i]))
+      return -1;
+  }
+  return p;
+}
+
+int NameIndex::getPosition(int i) const { return positions_[i]; }
+
+NameIndex::Hash NameIndex::hash(const string &name) const {
+  // FNV-1a over the lowercase bytes, folded as they are read.
+  uint64_t h = seed_;
+  for (int i = 0; i < name.size(); i++) {
+    h ^= foldCase(name[i]);
+    h *= 0x100000001b3ULL;
+  }
+
+  uint64_t a = mix(h), b = mix(h ^ 0x9e3779b97f4a7c15ULL);
+  uint32_t n = names_.size();
+  Hash result;
+  result.bucket = (a >> 32) % displacements_.size();
+  result.first = static_cast<uint32_t>(a) % n;
+  result.step = n > 1 ? b % (n - 1) + 1 : 0;
+  return result;
+}
+
+uint32_t NameIndex::position(const Hash &h) const {
+  const Displacement &d = displacements_[h.bucket];
+  return (h.first + static_cast<uint64_t>(d.times) * h.step + d.offset) %
+         names_.size();
+}
+
+bool NameIndex::place(const vector<Hash> &hashes) {
+  uint32_t n = hashes.size();
+
+  vector<vector<int>> buckets(displacements_.size());
+  for (int i = 0; i < n; i++) buckets[hashes[i].bucket].push_back(i);
+
+  // Place the largest buckets first, while there is the most room.
+  vector<int> order(buckets.size());
+  for (int i = 0; i < order.size(); i++) order[i] = i;
+  stable_sort(order.begin(), order.end(), [&buckets](int a, int b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  vector<bool> taken(n, false);
+  vector<uint32_t> positions;
+  for (int i = 0; i < order.size(); i++) {
+    const vector<int> &bucket = buckets[order[i]];
+    if (bucket.empty()) break;
+
+    // Try displacements until every name in the bucket lands on a free
+    // position that no other name in the bucket landed on. Single names
+    // always fit, since the offsets alone reach every position.
+    Displacement &d = displacements_[order[i]];
+    bool placed = false;
+    for (uint32_t times = 0; times < min(n, kMaxTimes) && !placed; times++) {
+      for (uint32_t offset = 0; offset < n && !placed; offset++) {
+        d = Displacement{times, offset};
+
+        positions.clear();
+        for (int j = 0; j < bucket.size(); j++) {
+          uint32_t p = position(hashes[bucket[j]]);
+          if (taken[p] || std::find(positions.begin(), positions.end(), p) !=
+                              positions.end())
+            break;
+          positions.push_back(p);
+        }
+        placed = positions.size() == bucket.size();
+      }
+    }
+    if (!placed) return false;
+
+    for (int j = 0; j < positions.size(); j++) taken[positions[j]] = true;
+  }
+
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef NAMEINDEX_INCLUDED
+#define NAMEINDEX_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal perfect hash over a fixed set of names, ignoring case. Each of the
+// n names is given its own position in [0, n), and a lookup costs one hash of
+// the query, two array reads and one comparison against the name stored at
+// the position found. Case is folded as the query is hashed and compared, so
+// lookups never copy or allocate.
+//
+// Built with CHD (compress, hash and displace): names are hashed into small
+// buckets, and the buckets are placed from largest to smallest, each one
+// with the first displacement that moves all of its names to free positions.
+class NameIndex {
+ public:
+  NameIndex();
+
+  // Index the given names, which must be distinct ignoring case. The name
+  // names[i] is then found at position getPosition(i). Returns false, and
+  // leaves the index empty, if two of the names are equal ignoring case.
+  bool build(const std::vector<std::string> &names);
+  int size() const;
+  // Position of the given name, or -1 if it is not one of the names.
+  int find(const std::string &name) const;
+  // Position of the name that was names[i] when the index was built.
+  int getPosition(int i) const;
+
+ private:
+  struct Hash {
+    uint32_t bucket;
+    uint32_t first;   // Position before displacement.
+    uint32_t step;    // Distance moved per unit of the first displacement.
+  };
+  struct Displacement {
+    uint32_t times;   // Multiple of the step to move by.
+    uint32_t offset;  // Extra distance to move by.
+  };
+
+  Hash hash(const std::string &name) const;
+  uint32_t position(const Hash &h) const;
+  // Try to place every bucket with the current seed.
+  bool place(const std::vector<Hash> &hashes);
+
+  uint64_t seed_;
+  std::vector<Displacement> displacements_;  // One per bucket.
+  std::vector<std::string> names_;           // Lowercase, by position.
+  std::vector<int> positions_;               // By order given to build.
+};
+
+#endif  // NAMEINDEX_INCLUDED
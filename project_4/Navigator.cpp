@@ -1,234 +1,590 @@
-#include "MyMap.h"
 #include "provided.h"
 #include "support.h"
-
+#include "AllocStats.h"
+#include "Directions.h"
+#include "SegmentIndex.h"
+#include "StreetGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <string>
 #include <vector>
-#include <queue>
 using namespace std;
 
-struct TravelCost {
-  StreetSegment segment;
-  vector<NavSegment> navigation;
-  double cost;       // Integrated cost, used for distance traveled so far.
-  double temp_cost;  // Temp cost, used for straight distance from end to dst.
+#ifdef NAV_STATS
+static double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+#endif
+
+// Route through the street graph between two points that lie on segments.
+// segments[0] carries the start point to nodes[0], segments[i] joins
+// nodes[i - 1] to nodes[i], and segments.back() carries nodes.back() to the end
+// point. A route with no nodes stays on a single segment.
+struct GraphRoute {
+  vector<int> nodes;
+  vector<int> segments;
+  double cost;
 };
 
-bool operator<(const TravelCost &a, const TravelCost &b) {
-  return a.cost + a.temp_cost > b.cost + b.temp_cost;
+bool operator<(const GraphRoute &a, const GraphRoute &b) {
+  return a.cost < b.cost;
+}
+
+// Search trees hold state for every node in the graph, so each thread keeps a
+// couple of them around and reuses them from one query to the next.
+static SearchTree &threadSearchTree(int which) {
+  static thread_local SearchTree trees[2];
+  return trees[which];
 }
 
 class NavigatorImpl {
  public:
   NavigatorImpl();
   ~NavigatorImpl();
-  bool loadMapData(string mapFile);
+  bool loadMapData(string mapFile, LoadStats &stats);
+  void setCompactDirections(bool compact);
   NavResult navigate(string start, string end,
+                     vector<NavSegment> &directions, NavStats &stats,
+                     vector<GeoSegment> *explored) const;
+  NavResult navigate(const GeoCoord &start, const GeoCoord &end,
                      vector<NavSegment> &directions) const;
+  bool snapToStreet(const GeoCoord &gc, GeoCoord &snapped,
+                    StreetSegment &segment) const;
+  NavResult navigateAlternatives(string start, string end, int k,
+                                 vector<vector<NavSegment>> &routes) const;
+  NavResult reachableWithin(string start, double miles, Isochrone &area) const;
 
  private:
-  string proceedAngleToString(double angle) const;
-  string turnAngleToString(double angle) const;
-  void finalizeNavSegments(vector<NavSegment> &segments) const;
-  double trueAngle(GeoSegment &seg1, GeoSegment &seg2) const;
+  // Alternative routes may be at most this much longer than the best route.
+  const double kMaxAlternativeStretch = 0.25;
+  // Alternative routes may share at most this fraction of their length with
+  // any route that was chosen before them.
+  const double kMaxAlternativeOverlap = 0.7;
+  // Alternative routes must have at least this fraction of their length lying
+  // on a plateau (a stretch that is a shortest path from both ends), which
+  // rules out routes with pointless detours.
+  const double kMinAlternativePlateau = 0.2;
+  // Coordinates are only snapped to streets at most this many miles away.
+  const double kMaxSnapMiles = 0.5;
+
+  // Find the shortest route between two points, given the ways onto the graph
+  // from the start and off of it to the destination.
+  NavResult search(const GeoCoord &src,
+                   const vector<StreetGraph::Access> &src_access,
+                   const GeoCoord &dst,
+                   const vector<StreetGraph::Access> &dst_access,
+                   vector<NavSegment> &directions, NavStats &stats,
+                   vector<GeoSegment> *explored) const;
+  // Snap a coordinate onto its nearest street and get the ways onto the graph
+  // from where it lands.
+  bool snapAccess(const GeoCoord &gc, GeoCoord &snapped,
+                  vector<StreetGraph::Access> &access) const;
+
+  // Route through the meeting point of a forward and a backward search tree.
+  bool viaRoute(const SearchTree &forward, const SearchTree &backward, int via,
+                GraphRoute &route) const;
+  // Length of the plateau that starts at the given node.
+  double plateauLength(const SearchTree &forward, const SearchTree &backward,
+                       int node) const;
+  // Add the attractions on a segment that are within reach, given how far the
+  // ends of the segment are, and note whether the segment is only partly
+  // within reach.
+  void addReachableSegment(int segment, double start_distance,
+                           double end_distance, double miles,
+                           Isochrone &area) const;
+  // Length of the route that runs along segments that the other route uses.
+  double sharedLength(const GraphRoute &route,
+                      const vector<int> &sorted_segments) const;
+  void routeToNavSegments(const GraphRoute &route, const GeoCoord &src,
+                          const GeoCoord &dst,
+                          vector<NavSegment> &segments) const;
 
   AttractionMapper attraction_mapper_;
   SegmentMapper segment_mapper_;
+  StreetGraph graph_;
+  SegmentIndex segment_index_;
+  bool compact_directions_;
 };
 
-NavigatorImpl::NavigatorImpl() {}
+NavigatorImpl::NavigatorImpl() : compact_directions_(false) {}
 
 NavigatorImpl::~NavigatorImpl() {}
 
-bool NavigatorImpl::loadMapData(string mapFile) {
+bool NavigatorImpl::loadMapData(string mapFile, LoadStats &stats) {
   MapLoader map_loader;
-  map_loader.load(mapFile);
+  AllocScope load_allocs;
+  bool loaded = map_loader.load(mapFile);
+  stats.load = load_allocs.counts();
+  if (!loaded) return false;
+
+  AllocScope index_allocs;
   attraction_mapper_.init(map_loader);
   segment_mapper_.init(map_loader);
+  graph_.build(map_loader);
+  segment_index_.build(graph_);
+  stats.index = index_allocs.counts();
 
   return true;
 }
 
+void NavigatorImpl::setCompactDirections(bool compact) {
+  compact_directions_ = compact;
+}
+
 NavResult NavigatorImpl::navigate(string start, string end,
-                                  vector<NavSegment> &directions) const {
+                                  vector<NavSegment> &directions,
+                                  NavStats &stats,
+                                  vector<GeoSegment> *explored) const {
   GeoCoord src, dst;
+  if (explored != nullptr) explored->clear();
+  NAV_STAT(stats = NavStats());
+  NAV_STAT(chrono::steady_clock::time_point phase_start =
+               chrono::steady_clock::now());
 
   // Sanitize the given start/end attractions based on whether they exist.
   if (!attraction_mapper_.getGeoCoord(start, src)) return NAV_BAD_SOURCE;
   if (!attraction_mapper_.getGeoCoord(end, dst)) return NAV_BAD_DESTINATION;
 
-  // Priority queue is sorted by the integral of distance traveled by the
-  // element up to the point that the element was popped, plus the distance
-  // between the end of the segment and the destination coordinate.
-  // This will prioritize shorter segments, and also favor segments that trend
-  // towards the destination.
-  priority_queue<TravelCost> to_go;
-  vector<StreetSegment> init_segments = segment_mapper_.getSegments(src);
-  MyMap<GeoCoord, bool> visited;  // Treat MyMap like a std::set (bool unused).
-
-  // Populate our priority queue with any segments associated with the start
-  // coordinate.
-  for (int i = 0; i < init_segments.size(); i++) {
-    vector<NavSegment> navigation;
-
-    GeoCoord start = src;
-    GeoSegment geo_segment = GeoSegment(start, GeoCoord());
-
-    double distance = 0;
-    string direction = "";
-    string street_name = init_segments.at(i).streetName;
-
-    navigation.push_back(NavSegment("", street_name, 0, geo_segment));
-
-    // Initial cost is total distance traveled in the current step and the
-    // distance that would be required to get to the destination.
-    to_go.push(TravelCost({init_segments.at(i), navigation, distance,
-                           distanceEarthMiles(geo_segment.end, dst)}));
+  NAV_STAT(stats.lookup_seconds = secondsSince(phase_start));
+
+  // Get onto the street graph at the ends of the segments that the start is
+  // on, and off of it at the ends of the segments that the destination is on.
+  vector<StreetGraph::Access> src_access, dst_access;
+  graph_.getAccess(src, segment_mapper_.getSegments(src), src_access);
+  graph_.getAccess(dst, segment_mapper_.getSegments(dst), dst_access);
+  NAV_STAT(stats.segment_lookups += 2);
+
+  return search(src, src_access, dst, dst_access, directions, stats, explored);
+}
+
+NavResult NavigatorImpl::navigate(const GeoCoord &start, const GeoCoord &end,
+                                  vector<NavSegment> &directions) const {
+  // Each coordinate becomes a point on its nearest street, which is then
+  // treated just like an attraction on that street.
+  GeoCoord src, dst;
+  vector<StreetGraph::Access> src_access, dst_access;
+  if (!snapAccess(start, src, src_access)) return NAV_BAD_SOURCE;
+  if (!snapAccess(end, dst, dst_access)) return NAV_BAD_DESTINATION;
+
+  NavStats stats;
+  return search(src, src_access, dst, dst_access, directions, stats, nullptr);
+}
+
+bool NavigatorImpl::snapToStreet(const GeoCoord &gc, GeoCoord &snapped,
+                                 StreetSegment &segment) const {
+  int nearest = segment_index_.findNearest(gc, kMaxSnapMiles, snapped);
+  if (nearest < 0) return false;
+
+  segment = graph_.getSegment(nearest);
+  return true;
+}
+
+bool NavigatorImpl::snapAccess(const GeoCoord &gc, GeoCoord &snapped,
+                               vector<StreetGraph::Access> &access) const {
+  int nearest = segment_index_.findNearest(gc, kMaxSnapMiles, snapped);
+  if (nearest < 0) return false;
+
+  // The snapped point leaves its segment through either end, as if the
+  // segment were split there.
+  int start = graph_.getSegmentStart(nearest);
+  int end = graph_.getSegmentEnd(nearest);
+  access.push_back(StreetGraph::Access{
+      start, nearest, distanceEarthMiles(snapped, graph_.getCoord(start))});
+  access.push_back(StreetGraph::Access{
+      end, nearest, distanceEarthMiles(snapped, graph_.getCoord(end))});
+  return true;
+}
+
+NavResult NavigatorImpl::search(const GeoCoord &src,
+                                const vector<StreetGraph::Access> &src_access,
+                                const GeoCoord &dst,
+                                const vector<StreetGraph::Access> &dst_access,
+                                vector<NavSegment> &directions,
+                                NavStats &stats,
+                                vector<GeoSegment> *explored) const {
+  NAV_STAT(chrono::steady_clock::time_point phase_start =
+               chrono::steady_clock::now());
+
+  // A route that never leaves the segment both attractions are on.
+  GraphRoute route;
+  route.cost = numeric_limits<double>::infinity();
+  for (int i = 0; i < src_access.size(); i++) {
+    for (int j = 0; j < dst_access.size(); j++) {
+      if (src_access.at(i).segment != dst_access.at(j).segment) continue;
+
+      route.segments.assign(1, src_access.at(i).segment);
+      route.cost = distanceEarthMiles(src, dst);
+    }
   }
 
-  while (to_go.size() > 0) {
-    TravelCost segment_cost = to_go.top();
-    to_go.pop();
-
-    // See if dst exists on this street.
-    for (int i = 0; i < segment_cost.segment.attractions.size(); i++) {
-      if (segment_cost.segment.attractions.at(i).name == end) {
-        // Finalize the last segment in the NavSegment history for the
-        // successful element popped from the priority_queue.
-        NavSegment &last_segment = segment_cost.navigation.back();
-        last_segment.m_geoSegment.end =
-            segment_cost.segment.attractions.at(i).geocoordinates;
-        last_segment.m_distance = distanceEarthMiles(
-            last_segment.m_geoSegment.start, last_segment.m_geoSegment.end);
-
-        finalizeNavSegments(segment_cost.navigation);
-
-        directions = segment_cost.navigation;
-        return NAV_SUCCESS;
-      }
+  // A* search from the start, which settles nodes in order of the distance
+  // traveled so far plus the straight-line distance left to the destination.
+  // This favors nodes that trend towards the destination while still
+  // guaranteeing the shortest route. Once nothing left to settle could lead
+  // to a shorter route than the best one found, that route is the answer.
+  SearchTree &tree = threadSearchTree(0);
+  tree.reset(graph_);
+  tree.setTarget(dst);
+  NAV_STAT(tree.setStats(&stats));
+  for (int i = 0; i < src_access.size(); i++) tree.seed(src_access.at(i));
+
+  int exit_node = -1, exit_segment = -1;
+  while (tree.peekDistance() < route.cost) {
+    int node = tree.settleNext();
+
+    if (explored != nullptr) {
+      int parent = tree.getParent(node);
+      explored->push_back(GeoSegment(
+          graph_.getCoord(node),
+          parent == SearchTree::kNoParent ? src : graph_.getCoord(parent)));
     }
 
-    // Consider both ends of the street.
-    vector<GeoCoord> travel_to;
-    travel_to.push_back(segment_cost.segment.segment.start);
-    travel_to.push_back(segment_cost.segment.segment.end);
-
-    for (int i = 0; i < travel_to.size(); i++) {
-      // Don't re-examine geocoords that we already visited.
-      bool *gc = visited.find(travel_to.at(i));
-      if (gc != nullptr) continue;
-      visited.associate(travel_to.at(i), true);
-
-      vector<StreetSegment> new_segments =
-          segment_mapper_.getSegments(travel_to.at(i));
-
-      for (int j = 0; j < new_segments.size(); j++) {
-        // Analyze only the street segments at GeoCoord junctions that are not
-        // the same as the segment currently being analyzed.
-        if (new_segments.at(j).segment == segment_cost.segment.segment)
-          continue;
-
-        // Finish off the last NavSegment and start a new one containing just
-        // the name of the current street and the current coordinate.
-        // This makes each NavSegment a continuation of the one before it.
-        vector<NavSegment> new_nav;
-        new_nav.insert(new_nav.end(), segment_cost.navigation.begin(),
-                       segment_cost.navigation.end());
-
-        NavSegment &from_segment = new_nav.back();
-        from_segment.m_geoSegment.end = travel_to.at(i);
-
-        double distance = distanceEarthMiles(from_segment.m_geoSegment.start,
-                                             from_segment.m_geoSegment.end);
-        from_segment.m_distance = distance;
-
-        NavSegment to_segment("", new_segments.at(j).streetName, 0,
-                              GeoSegment(travel_to.at(i), GeoCoord()));
-        new_nav.push_back(to_segment);
-
-        // Sort this possible route in the priority_queue based on its current
-        // length and the distance between the end of the head of the route and
-        // the destination.
-        // This prioritizes shorter routes and routes that will get closer to
-        // the destination faster.
-        to_go.push(TravelCost({new_segments.at(j), new_nav,
-                               segment_cost.cost + distance,
-                               distanceEarthMiles(travel_to.at(i), dst)}));
-      }
+    // Leaving the graph here may make a shorter route to the destination.
+    for (int i = 0; i < dst_access.size(); i++) {
+      double cost = tree.getDistance(node) + dst_access.at(i).length;
+      if (dst_access.at(i).node != node || cost >= route.cost) continue;
+
+      route.cost = cost;
+      exit_node = node;
+      exit_segment = dst_access.at(i).segment;
     }
   }
 
-  return NAV_NO_ROUTE;
-}
+  if (exit_node >= 0) {
+    // Walk back from where the route leaves the graph to the start.
+    route.nodes.clear();
+    route.segments.assign(1, exit_segment);
+    for (int node = exit_node; node != SearchTree::kNoParent;
+         node = tree.getParent(node)) {
+      route.nodes.push_back(node);
+      route.segments.push_back(tree.getParentSegment(node));
+    }
+    reverse(route.nodes.begin(), route.nodes.end());
+    reverse(route.segments.begin(), route.segments.end());
+  }
 
-string NavigatorImpl::proceedAngleToString(double angle) const {
-  angle = fmod(angle, 360.0);
+  NAV_STAT(stats.search_seconds = secondsSince(phase_start));
+  if (route.segments.empty()) return NAV_NO_ROUTE;
 
-  if (angle < 0 || angle >= 360)
-    return "INVALID";
-  else if (angle <= 22.5)
-    return "east";
-  else if (angle <= 67.5)
-    return "northeast";
-  else if (angle <= 112.5)
-    return "north";
-  else if (angle <= 157.5)
-    return "northwest";
-  else if (angle <= 202.5)
-    return "west";
-  else if (angle <= 247.5)
-    return "southwest";
-  else if (angle <= 292.5)
-    return "south";
-  else if (angle <= 337.5)
-    return "southeast";
-  else if (angle < 360)
-    return "east";
+  NAV_STAT(phase_start = chrono::steady_clock::now());
+  routeToNavSegments(route, src, dst, directions);
+  NAV_STAT(stats.finalize_seconds = secondsSince(phase_start));
 
-  return "INVALID";
+  return NAV_SUCCESS;
 }
 
-string NavigatorImpl::turnAngleToString(double angle) const {
-  if (angle < 0 || angle >= 360) return "INVALID";
+NavResult NavigatorImpl::navigateAlternatives(
+    string start, string end, int k, vector<vector<NavSegment>> &routes) const {
+  GeoCoord src, dst;
+  routes.clear();
 
-  if (angle < 180) return "left";
-  return "right";
+  if (!attraction_mapper_.getGeoCoord(start, src)) return NAV_BAD_SOURCE;
+  if (!attraction_mapper_.getGeoCoord(end, dst)) return NAV_BAD_DESTINATION;
+  if (k < 1) return NAV_SUCCESS;  // Up to no routes at all.
+
+  // Routes are found with the plateau method: grow a shortest path tree from
+  // the start and another one from the end, and look for stretches where the
+  // two trees agree. Each such plateau is a locally optimal detour, so every
+  // candidate route comes out of the same two searches instead of needing a
+  // search of its own.
+  vector<StreetGraph::Access> src_access, dst_access;
+  graph_.getAccess(src, segment_mapper_.getSegments(src), src_access);
+  graph_.getAccess(dst, segment_mapper_.getSegments(dst), dst_access);
+
+  SearchTree &forward = threadSearchTree(0);
+  SearchTree &backward = threadSearchTree(1);
+  forward.reset(graph_);
+  backward.reset(graph_);
+  for (int i = 0; i < src_access.size(); i++) forward.seed(src_access.at(i));
+  for (int i = 0; i < dst_access.size(); i++) backward.seed(dst_access.at(i));
+
+  // A route that never leaves the segment both attractions are on.
+  GraphRoute best;
+  best.cost = numeric_limits<double>::infinity();
+  for (int i = 0; i < src_access.size(); i++) {
+    for (int j = 0; j < dst_access.size(); j++) {
+      if (src_access.at(i).segment != dst_access.at(j).segment) continue;
+
+      best.segments.assign(1, src_access.at(i).segment);
+      best.cost = distanceEarthMiles(src, dst);
+    }
+  }
+
+  // Interleave the two searches, always growing the one with the closer
+  // frontier, until no unsettled pair of nodes could still make a route short
+  // enough to be an alternative.
+  double shortest = best.cost;
+  int meeting = -1;
+  vector<int> settled_nodes;
+  while (true) {
+    double bound = (1 + kMaxAlternativeStretch) * shortest;
+    double forward_next = forward.peekDistance();
+    double backward_next = backward.peekDistance();
+    if (forward_next + backward_next > bound) break;
+
+    bool grow_forward = forward_next <= backward_next;
+    SearchTree &tree = grow_forward ? forward : backward;
+    const SearchTree &other = grow_forward ? backward : forward;
+    int node = tree.settleNext();
+    if (node < 0) break;
+
+    settled_nodes.push_back(node);
+    if (!other.reached(node)) continue;
+
+    double cost = forward.getDistance(node) + backward.getDistance(node);
+    if (cost < shortest) {
+      shortest = cost;
+      meeting = node;
+    }
+  }
+
+  if (meeting >= 0) viaRoute(forward, backward, meeting, best);
+  if (best.segments.empty()) return NAV_NO_ROUTE;
+
+  // Every plateau start that both searches reached is a candidate. Consider
+  // the shortest candidates first, skipping those that are mostly detour.
+  vector<GraphRoute> candidates;
+  double bound = (1 + kMaxAlternativeStretch) * best.cost;
+  for (int i = 0; i < settled_nodes.size() && k > 1; i++) {
+    int node = settled_nodes.at(i);
+    if (!forward.reached(node) || !backward.reached(node)) continue;
+
+    double cost = forward.getDistance(node) + backward.getDistance(node);
+    if (cost > bound) continue;
+
+    double plateau = plateauLength(forward, backward, node);
+    if (plateau <= 0 || plateau < kMinAlternativePlateau * cost) continue;
+
+    GraphRoute candidate;
+    if (viaRoute(forward, backward, node, candidate))
+      candidates.push_back(candidate);
+  }
+  sort(candidates.begin(), candidates.end());
+
+  // Accept candidates in order as long as they differ enough from every route
+  // accepted so far.
+  vector<GraphRoute> chosen(1, best);
+  vector<vector<int>> chosen_segments(1, best.segments);
+  sort(chosen_segments.back().begin(), chosen_segments.back().end());
+
+  for (int i = 0; i < candidates.size() && chosen.size() < k; i++) {
+    const GraphRoute &candidate = candidates.at(i);
+
+    bool distinct = true;
+    for (int j = 0; j < chosen_segments.size() && distinct; j++) {
+      distinct = sharedLength(candidate, chosen_segments.at(j)) <=
+                 kMaxAlternativeOverlap * candidate.cost;
+    }
+    if (!distinct) continue;
+
+    chosen.push_back(candidate);
+    chosen_segments.push_back(candidate.segments);
+    sort(chosen_segments.back().begin(), chosen_segments.back().end());
+  }
+
+  routes.resize(chosen.size());
+  for (int i = 0; i < chosen.size(); i++)
+    routeToNavSegments(chosen.at(i), src, dst, routes.at(i));
+
+  return NAV_SUCCESS;
 }
 
-void NavigatorImpl::finalizeNavSegments(vector<NavSegment> &segments) const {
-  for (int i = 0; i < segments.size(); i++) {
-    if (i > 0) {
-      if (segments.at(i).m_streetName != segments.at(i - 1).m_streetName) {
-        // Turn found, so fill in the appropriate fields and insert a turn
-        // segment.
-        double angle = angleBetween2Lines(segments.at(i - 1).m_geoSegment,
-                                          segments.at(i).m_geoSegment);
+NavResult NavigatorImpl::reachableWithin(string start, double miles,
+                                         Isochrone &area) const {
+  GeoCoord src;
+  area = Isochrone();
+
+  if (!attraction_mapper_.getGeoCoord(start, src)) return NAV_BAD_SOURCE;
 
-        NavSegment turn_seg =
-            NavSegment(turnAngleToString(angle), segments.at(i).m_streetName);
-        segments.insert(segments.begin() + i, turn_seg);
+  vector<StreetGraph::Access> src_access;
+  graph_.getAccess(src, segment_mapper_.getSegments(src), src_access);
+
+  // Bound the search by the given distance, so that the work done depends on
+  // the size of the area rather than the size of the map.
+  SearchTree &tree = threadSearchTree(0);
+  tree.reset(graph_, miles);
+  for (int i = 0; i < src_access.size(); i++) tree.seed(src_access.at(i));
+
+  // The segments the attraction is on can also be traveled directly from the
+  // attraction. Access points come in pairs, one for each end of a segment.
+  for (int i = 0; i + 1 < src_access.size(); i += 2) {
+    int segment = src_access.at(i).segment;
+    const vector<Attraction> &attractions =
+        graph_.getSegment(segment).attractions;
+
+    for (int j = 0; j < attractions.size(); j++) {
+      if (distanceEarthMiles(src, attractions.at(j).geocoordinates) <= miles)
+        area.attractions.push_back(attractions.at(j));
+    }
+
+    if (src_access.at(i).length > miles || src_access.at(i + 1).length > miles)
+      area.frontier.push_back(graph_.getSegment(segment));
+  }
 
+  for (int node = tree.settleNext(); node >= 0;
+       node = tree.settleNext()) {
+    area.intersections.push_back(graph_.getCoord(node));
+
+    for (const StreetGraph::Edge *e = graph_.edgesBegin(node);
+         e != graph_.edgesEnd(node); e++) {
+      // Look at each segment once: from its only settled end, or from the
+      // lower numbered end if both are settled. The segments the attraction
+      // is on were handled above.
+      bool from_start = false;
+      for (int i = 0; i < src_access.size(); i++)
+        from_start = from_start || src_access.at(i).segment == e->segment;
+      if (from_start) continue;
+
+      // Edges that join an attraction to the ends of its segment only cover
+      // part of the segment, which is otherwise handled from its ends. Only
+      // when neither end is within reach is it handled from the attraction.
+      int segment_start = graph_.getSegmentStart(e->segment);
+      int segment_end = graph_.getSegmentEnd(e->segment);
+      if (node != segment_start && node != segment_end) {
+        if (e->to == segment_start && !tree.settled(segment_start) &&
+            !tree.settled(segment_end)) {
+          double distance = tree.getDistance(node);
+          addReachableSegment(
+              e->segment, distance + e->length,
+              distance + distanceEarthMiles(graph_.getCoord(node),
+                                            graph_.getCoord(segment_end)),
+              miles, area);
+        }
         continue;
+      }
+      if (e->to != segment_start && e->to != segment_end) continue;
+
+      if (e->to == node || (tree.settled(e->to) && e->to < node)) continue;
+
+      if (segment_start == node) {
+        addReachableSegment(e->segment, tree.getDistance(node),
+                            tree.getDistance(e->to), miles, area);
       } else {
-        // Fill in the direction that the proceed segment faces.
-        segments.at(i).m_direction = proceedAngleToString(trueAngle(
-            segments.at(i - 1).m_geoSegment, segments.at(i).m_geoSegment));
+        addReachableSegment(e->segment, tree.getDistance(e->to),
+                            tree.getDistance(node), miles, area);
       }
-    } else {
-      // Start segment, so base the direction off of the raw angle of the
-      // segment rather than basing the angle off the previous segment.
-      GeoSegment &geo_segment = segments.at(i).m_geoSegment;
-      double distance = distanceEarthMiles(geo_segment.start, geo_segment.end);
-
-      segments.at(i).m_distance = distance;
-      segments.at(i).m_direction =
-          proceedAngleToString(angleOfLine(segments.at(i).m_geoSegment));
     }
   }
+
+  return NAV_SUCCESS;
+}
+
+void NavigatorImpl::addReachableSegment(int segment, double start_distance,
+                                        double end_distance, double miles,
+                                        Isochrone &area) const {
+  const StreetSegment &street_segment = graph_.getSegment(segment);
+  const GeoSegment &geo_segment = street_segment.segment;
+
+  for (int i = 0; i < street_segment.attractions.size(); i++) {
+    const Attraction &attraction = street_segment.attractions.at(i);
+    double distance = min(
+        start_distance +
+            distanceEarthMiles(geo_segment.start, attraction.geocoordinates),
+        end_distance +
+            distanceEarthMiles(geo_segment.end, attraction.geocoordinates));
+
+    if (distance <= miles) area.attractions.push_back(attraction);
+  }
+
+  // Coming in from both ends, every point of the segment is within reach
+  // exactly when the two distances plus the segment's length fit in twice the
+  // allowance.
+  double length = distanceEarthMiles(geo_segment.start, geo_segment.end);
+  if (start_distance + end_distance + length > 2 * miles)
+    area.frontier.push_back(street_segment);
+}
+
+bool NavigatorImpl::viaRoute(const SearchTree &forward,
+                             const SearchTree &backward, int via,
+                             GraphRoute &route) const {
+  route.nodes.clear();
+  route.segments.clear();
+  route.cost = forward.getDistance(via) + backward.getDistance(via);
+
+  // Walk from the via node back to the start, then reverse that half.
+  for (int node = via; node != SearchTree::kNoParent;
+       node = forward.getParent(node)) {
+    route.nodes.push_back(node);
+    route.segments.push_back(forward.getParentSegment(node));
+  }
+  reverse(route.nodes.begin(), route.nodes.end());
+  reverse(route.segments.begin(), route.segments.end());
+
+  // Then walk from the via node on to the end.
+  for (int node = via; node != SearchTree::kNoParent;
+       node = backward.getParent(node)) {
+    if (node != via) route.nodes.push_back(node);
+    route.segments.push_back(backward.getParentSegment(node));
+  }
+
+  // The two halves come from different trees, so they may cross each other.
+  // Such a route would visit an intersection twice, so reject it.
+  vector<int> sorted_nodes = route.nodes;
+  sort(sorted_nodes.begin(), sorted_nodes.end());
+  return adjacent_find(sorted_nodes.begin(), sorted_nodes.end()) ==
+         sorted_nodes.end();
+}
+
+double NavigatorImpl::plateauLength(const SearchTree &forward,
+                                    const SearchTree &backward,
+                                    int node) const {
+  // A plateau is a run of segments that both trees use in the same direction:
+  // the backward tree heads from a node to its parent, and the forward tree
+  // reached that parent from the node. Only measure from the first node of a
+  // plateau so that each plateau is counted once.
+  int previous = forward.getParent(node);
+  if (previous != SearchTree::kNoParent &&
+      backward.getParent(previous) == node &&
+      backward.getParentSegment(previous) == forward.getParentSegment(node))
+    return 0;
+
+  double length = 0;
+  for (int next = backward.getParent(node);
+       next != SearchTree::kNoParent && forward.getParent(next) == node &&
+       forward.getParentSegment(next) == backward.getParentSegment(node);
+       node = next, next = backward.getParent(node)) {
+    length += forward.getDistance(next) - forward.getDistance(node);
+  }
+
+  return length;
+}
+
+double NavigatorImpl::sharedLength(const GraphRoute &route,
+                                   const vector<int> &sorted_segments) const {
+  double length = 0;
+  for (int i = 1; i < route.nodes.size(); i++) {
+    if (!binary_search(sorted_segments.begin(), sorted_segments.end(),
+                       route.segments.at(i)))
+      continue;
+
+    length += distanceEarthMiles(graph_.getCoord(route.nodes.at(i - 1)),
+                                 graph_.getCoord(route.nodes.at(i)));
+  }
+
+  return length;
 }
 
-double NavigatorImpl::trueAngle(GeoSegment &seg1, GeoSegment &seg2) const {
-  return angleOfLine(seg1) + angleBetween2Lines(seg1, seg2);
+void NavigatorImpl::routeToNavSegments(const GraphRoute &route,
+                                       const GeoCoord &src, const GeoCoord &dst,
+                                       vector<NavSegment> &segments) const {
+  // Produce one proceed segment per street segment traveled, and let
+  // makeDirections add the directions and turns.
+  vector<NavSegment> legs;
+  legs.reserve(route.segments.size());
+  for (int i = 0; i < route.segments.size(); i++) {
+    const GeoCoord &from =
+        i == 0 ? src : graph_.getCoord(route.nodes.at(i - 1));
+    const GeoCoord &to =
+        i == route.nodes.size() ? dst : graph_.getCoord(route.nodes.at(i));
+
+    legs.push_back(
+        NavSegment("", graph_.getSegment(route.segments.at(i)).streetName,
+                   distanceEarthMiles(from, to), GeoSegment(from, to)));
+  }
+
+  makeDirections(legs, compact_directions_, segments);
 }
 
 //******************** Navigator functions ************************************
@@ -241,10 +597,57 @@ Navigator::Navigator() { m_impl = new NavigatorImpl; }
 Navigator::~Navigator() { delete m_impl; }
 
 bool Navigator::loadMapData(string mapFile) {
-  return m_impl->loadMapData(mapFile);
+  LoadStats stats;
+  return m_impl->loadMapData(mapFile, stats);
+}
+
+bool Navigator::loadMapData(string mapFile, LoadStats &stats) {
+  return m_impl->loadMapData(mapFile, stats);
+}
+
+void Navigator::setCompactDirections(bool compact) {
+  m_impl->setCompactDirections(compact);
 }
 
 NavResult Navigator::navigate(string start, string end,
                               vector<NavSegment> &directions) const {
+  NavStats stats;
+  return m_impl->navigate(start, end, directions, stats, nullptr);
+}
+
+NavResult Navigator::navigate(string start, string end,
+                              vector<NavSegment> &directions,
+                              NavStats &stats) const {
+  AllocScope allocs;
+  NavResult result = m_impl->navigate(start, end, directions, stats, nullptr);
+  stats.heap = allocs.counts();
+  return result;
+}
+
+NavResult Navigator::navigate(string start, string end,
+                              vector<NavSegment> &directions,
+                              vector<GeoSegment> &explored) const {
+  NavStats stats;
+  return m_impl->navigate(start, end, directions, stats, &explored);
+}
+
+NavResult Navigator::navigate(const GeoCoord &start, const GeoCoord &end,
+                              vector<NavSegment> &directions) const {
   return m_impl->navigate(start, end, directions);
 }
+
+bool Navigator::snapToStreet(const GeoCoord &gc, GeoCoord &snapped,
+                             StreetSegment &segment) const {
+  return m_impl->snapToStreet(gc, snapped, segment);
+}
+
+NavResult Navigator::navigateAlternatives(
+    string start, string end, int k,
+    vector<vector<NavSegment>> &routes) const {
+  return m_impl->navigateAlternatives(start, end, k, routes);
+}
+
+NavResult Navigator::reachableWithin(string start, double miles,
+                                     Isochrone &area) const {
+  return m_impl->reachableWithin(start, miles, area);
+}
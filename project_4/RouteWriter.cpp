@@ -0,0 +1,149 @@
+#include "RouteWriter.h"
+#include "support.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+
+RouteWriter::RouteWriter() {}
+
+void RouteWriter::writeGeoJson(const string &start, const string &end,
+                               const vector<NavSegment> &directions) {
+  double miles = 0;
+  append("{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+         "\"coordinates\":[");
+
+  // A route runs through the start of its first proceed and then the end of
+  // every proceed. Points where nothing moved are left out.
+  const GeoCoord *last = nullptr;
+  for (int i = 0; i < directions.size(); i++) {
+    const NavSegment &segment = directions[i];
+    if (segment.m_command != NavSegment::PROCEED) continue;
+
+    if (last == nullptr) {
+      appendCoord(segment.m_geoSegment.start);
+      last = &segment.m_geoSegment.start;
+    }
+    if (!(segment.m_geoSegment.end == *last)) {
+      append(',');
+      appendCoord(segment.m_geoSegment.end);
+      last = &segment.m_geoSegment.end;
+    }
+
+    miles += segment.m_distance;
+  }
+
+  append("]},\"properties\":{\"start\":");
+  appendQuoted(start);
+  append(",\"end\":");
+  appendQuoted(end);
+
+  char number[32];
+  snprintf(number, sizeof(number), ",\"miles\":%.4f}}\n", miles);
+  append(number);
+}
+
+void RouteWriter::writeGeoJson(const vector<GeoSegment> &explored) {
+  append("{\"type\":\"Feature\",\"geometry\":{\"type\":\"MultiLineString\","
+         "\"coordinates\":[");
+
+  for (int i = 0; i < explored.size(); i++) {
+    if (i > 0) append(',');
+    append('[');
+    appendCoord(explored[i].start);
+    append(',');
+    appendCoord(explored[i].end);
+    append(']');
+  }
+
+  append("]},\"properties\":{\"explored\":true}}\n");
+}
+
+void RouteWriter::writePolyline(const vector<NavSegment> &directions) {
+  // Every point is written as the difference from the one before it, in
+  // hundred-thousandths of a degree.
+  long latitude = 0, longitude = 0;
+  bool first = true;
+
+  for (int i = 0; i < directions.size(); i++) {
+    const NavSegment &segment = directions[i];
+    if (segment.m_command != NavSegment::PROCEED) continue;
+
+    for (int end = first ? 0 : 1; end < 2; end++) {
+      const GeoCoord &gc =
+          end == 0 ? segment.m_geoSegment.start : segment.m_geoSegment.end;
+      long next_latitude = lround(gc.latitude * 1e5);
+      long next_longitude = lround(gc.longitude * 1e5);
+      if (!first && next_latitude == latitude && next_longitude == longitude)
+        continue;
+
+      appendPolylineValue(next_latitude - latitude);
+      appendPolylineValue(next_longitude - longitude);
+      latitude = next_latitude;
+      longitude = next_longitude;
+      first = false;
+    }
+  }
+
+  append('\n');
+}
+
+const char *RouteWriter::data() const { return buffer_.data(); }
+
+size_t RouteWriter::size() const { return buffer_.size(); }
+
+void RouteWriter::clear() { buffer_.clear(); }
+
+bool RouteWriter::flush(FILE *out) {
+  bool written =
+      fwrite(buffer_.data(), 1, buffer_.size(), out) == buffer_.size();
+  clear();
+  return written;
+}
+
+void RouteWriter::append(char c) { buffer_ += c; }
+
+void RouteWriter::append(const char *text) { buffer_ += text; }
+
+void RouteWriter::appendQuoted(const string &text) {
+  static const char kHex[] = "0123456789abcdef";
+
+  append('"');
+  for (int i = 0; i < text.size(); i++) {
+    unsigned char c = text[i];
+    if (c == '"' || c == '\\') {
+      append('\\');
+      append(c);
+    } else if (c < 0x20) {
+      append("\\u00");
+      append(kHex[c >> 4]);
+      append(kHex[c & 0xf]);
+    } else {
+      append(c);
+    }
+  }
+  append('"');
+}
+
+void RouteWriter::appendCoord(const GeoCoord &gc) {
+  // GeoJSON puts longitude first.
+  append('[');
+  buffer_ += gc.longitudeText;
+  append(',');
+  buffer_ += gc.latitudeText;
+  append(']');
+}
+
+void RouteWriter::appendPolylineValue(long delta) {
+  // Shift the sign into the lowest bit, then write five bits at a time, low
+  // bits first, setting 0x20 on every chunk but the last.
+  unsigned long value = delta < 0 ? ~(static_cast<unsigned long>(delta) << 1)
+                                  : static_cast<unsigned long>(delta) << 1;
+  while (value >= 0x20) {
+    append(static_cast<char>((0x20 | (value & 0x1f)) + 63));
+    value >>= 5;
+  }
+  append(static_cast<char>(value + 63));
+}
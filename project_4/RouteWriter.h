@@ -0,0 +1,47 @@
+#ifndef ROUTEWRITER_INCLUDED
+#define ROUTEWRITER_INCLUDED
+
+#include "provided.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes routes in formats that mapping tools read, one route per line, into
+// a buffer that is kept from one batch to the next. Once the buffer has grown
+// to the size of a batch, writing does no allocation at all. Coordinates are
+// copied straight from the map's coordinate text for GeoJSON, and encoded
+// straight from the coordinates for polylines, without going through streams.
+class RouteWriter {
+ public:
+  RouteWriter();
+
+  // Append a route as a GeoJSON Feature holding a LineString, with the names
+  // of its ends and its length in miles as properties. A batch of these is a
+  // GeoJSON text sequence with one feature per line.
+  void writeGeoJson(const std::string &start, const std::string &end,
+                    const std::vector<NavSegment> &directions);
+  // Append the tree explored by a search as a GeoJSON Feature holding a
+  // MultiLineString.
+  void writeGeoJson(const std::vector<GeoSegment> &explored);
+  // Append a route in the encoded polyline format, with five decimals.
+  void writePolyline(const std::vector<NavSegment> &directions);
+
+  const char *data() const;
+  size_t size() const;
+  // Forget everything written, keeping the buffer for the next batch.
+  void clear();
+  // Write everything written so far to the file and clear the buffer.
+  bool flush(std::FILE *out);
+
+ private:
+  void append(char c);
+  void append(const char *text);
+  void appendQuoted(const std::string &text);
+  void appendCoord(const GeoCoord &gc);
+  void appendPolylineValue(long delta);
+
+  std::string buffer_;
+};
+
+#endif  // ROUTEWRITER_INCLUDED
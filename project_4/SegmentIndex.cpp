@@ -0,0 +1,198 @@
+#include "SegmentIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Average number of segments per cell the grid is sized for.
+static const int kSegmentsPerCell = 2;
+
+// Miles in a degree of latitude, on the sphere that distanceEarthMiles uses.
+static const double kMilesPerDegree = 6371.0 * 0.621371 * M_PI / 180;
+
+// Points closer than this to a segment, in degrees, are taken to be on it.
+// Map coordinates have seven decimals, so this is below their resolution.
+static const double kOnSegment = 1e-7;
+
+// Coordinate text for a point that is not in the map, to the same seven
+// decimals as the map's own coordinates.
+static GeoCoord makeGeoCoord(double latitude, double longitude) {
+  char latitude_text[32], longitude_text[32];
+  snprintf(latitude_text, sizeof(latitude_text), "%.7f", latitude);
+  snprintf(longitude_text, sizeof(longitude_text), "%.7f", longitude);
+  return GeoCoord(latitude_text, longitude_text);
+}
+
+SegmentIndex::SegmentIndex()
+    : graph_(nullptr),
+      min_latitude_(0),
+      min_longitude_(0),
+      longitude_scale_(1),
+      cell_size_(1),
+      columns_(0),
+      rows_(0) {}
+
+void SegmentIndex::build(const StreetGraph &graph) {
+  graph_ = &graph;
+  columns_ = rows_ = 0;
+  first_entry_.clear();
+  entries_.clear();
+  if (graph.getNumNodes() == 0) return;
+
+  double max_latitude = graph.getCoord(0).latitude;
+  double max_longitude = graph.getCoord(0).longitude;
+  min_latitude_ = max_latitude;
+  min_longitude_ = max_longitude;
+  for (int i = 1; i < graph.getNumNodes(); i++) {
+    const GeoCoord &gc = graph.getCoord(i);
+    min_latitude_ = min(min_latitude_, gc.latitude);
+    max_latitude = max(max_latitude, gc.latitude);
+    min_longitude_ = min(min_longitude_, gc.longitude);
+    max_longitude = max(max_longitude, gc.longitude);
+  }
+  longitude_scale_ = cos(deg2rad((min_latitude_ + max_latitude) / 2));
+
+  // Size square cells so that there are a couple of segments per cell.
+  double width = (max_longitude - min_longitude_) * longitude_scale_;
+  double height = max_latitude - min_latitude_;
+  int num_cells = max(1, graph.getNumSegments() / kSegmentsPerCell);
+  cell_size_ = max(sqrt(width * height / num_cells),
+                   max(width, height) / num_cells);
+  if (!(cell_size_ > 0)) cell_size_ = 1;
+  columns_ = width / cell_size_ + 1;
+  rows_ = height / cell_size_ + 1;
+
+  // List every segment in each cell its bounding box overlaps, counting the
+  // entries of each cell first so they can be laid out contiguously.
+  first_entry_.assign(columns_ * rows_ + 1, 0);
+  for (int pass = 0; pass < 2; pass++) {
+    vector<int> next_entry(first_entry_.begin(), first_entry_.end() - 1);
+
+    for (int i = 0; i < graph.getNumSegments(); i++) {
+      Point a = project(graph.getCoord(graph.getSegmentStart(i)));
+      Point b = project(graph.getCoord(graph.getSegmentEnd(i)));
+
+      for (int x = column(min(a.x, b.x)); x <= column(max(a.x, b.x)); x++) {
+        for (int y = row(min(a.y, b.y)); y <= row(max(a.y, b.y)); y++) {
+          int cell = y * columns_ + x;
+          if (pass == 0)
+            first_entry_[cell + 1]++;
+          else
+            entries_[next_entry[cell]++] = i;
+        }
+      }
+    }
+
+    if (pass == 0) {
+      for (int i = 0; i < columns_ * rows_; i++)
+        first_entry_[i + 1] += first_entry_[i];
+      entries_.resize(first_entry_.back());
+    }
+  }
+}
+
+int SegmentIndex::findNearest(const GeoCoord &gc, double max_miles,
+                              GeoCoord &snapped) const {
+  if (columns_ == 0) return -1;
+
+  Point p = project(gc);
+  double max_distance = max_miles / kMilesPerDegree;
+  double best = max_distance * max_distance, best_along = 0;
+  int best_segment = -1;
+
+  // The cell the point is in, which may lie outside the grid.
+  int cx = floor(p.x / cell_size_), cy = floor(p.y / cell_size_);
+
+  for (int r = 0;; r++) {
+    // Every cell from this ring outwards lies outside the square of cells
+    // searched so far, so nothing in them is nearer than its edge.
+    double edge = min(min(p.x - (cx - r + 1) * cell_size_,
+                          (cx + r) * cell_size_ - p.x),
+                      min(p.y - (cy - r + 1) * cell_size_,
+                          (cy + r) * cell_size_ - p.y));
+    if (r > 0 && edge * edge > best) break;
+
+    for (int y = max(cy - r, 0); y <= min(cy + r, rows_ - 1); y++) {
+      // Only the first and last rows of the ring are searched all the way
+      // across; the rows in between just have a cell at each end.
+      bool full_row = y == cy - r || y == cy + r;
+      int step = full_row || r == 0 ? 1 : 2 * r;
+
+      for (int x = cx - r; x <= cx + r; x += step) {
+        if (x < 0 || x >= columns_) continue;
+
+        int cell = y * columns_ + x;
+        for (int i = first_entry_[cell]; i < first_entry_[cell + 1]; i++) {
+          double along;
+          double distance = distanceToSegment(p, entries_[i], along);
+          if (distance > best || (distance == best && best_segment >= 0))
+            continue;
+
+          best = distance;
+          best_along = along;
+          best_segment = entries_[i];
+        }
+      }
+    }
+
+    // Stop once the ring has taken in the whole grid.
+    if (cx - r <= 0 && cy - r <= 0 && cx + r >= columns_ - 1 &&
+        cy + r >= rows_ - 1)
+      break;
+  }
+
+  if (best_segment < 0) return -1;
+
+  // Points already on the segment stay where they are, and ends of the
+  // segment keep their own coordinates, so that a point that snaps to one
+  // lands exactly on the node there.
+  const GeoCoord &start =
+      graph_->getCoord(graph_->getSegmentStart(best_segment));
+  const GeoCoord &end = graph_->getCoord(graph_->getSegmentEnd(best_segment));
+  if (best <= kOnSegment * kOnSegment) {
+    snapped = gc;
+  } else if (best_along <= 0) {
+    snapped = start;
+  } else if (best_along >= 1) {
+    snapped = end;
+  } else {
+    snapped = makeGeoCoord(
+        start.latitude + best_along * (end.latitude - start.latitude),
+        start.longitude + best_along * (end.longitude - start.longitude));
+  }
+
+  return best_segment;
+}
+
+SegmentIndex::Point SegmentIndex::project(const GeoCoord &gc) const {
+  return Point{(gc.longitude - min_longitude_) * longitude_scale_,
+               gc.latitude - min_latitude_};
+}
+
+int SegmentIndex::column(double x) const {
+  return min(max(static_cast<int>(x / cell_size_), 0), columns_ - 1);
+}
+
+int SegmentIndex::row(double y) const {
+  return min(max(static_cast<int>(y / cell_size_), 0), rows_ - 1);
+}
+
+double SegmentIndex::distanceToSegment(const Point &p, int segment,
+                                       double &along) const {
+  Point a = project(graph_->getCoord(graph_->getSegmentStart(segment)));
+  Point b = project(graph_->getCoord(graph_->getSegmentEnd(segment)));
+
+  double dx = b.x - a.x, dy = b.y - a.y;
+  double length_squared = dx * dx + dy * dy;
+  along = 0;
+  if (length_squared > 0) {
+    along = ((p.x - a.x) * dx + (p.y - a.y) * dy) / length_squared;
+    along = min(max(along, 0.0), 1.0);
+  }
+
+  double nx = a.x + along * dx - p.x, ny = a.y + along * dy - p.y;
+  return nx * nx + ny * ny;
+}
@@ -0,0 +1,57 @@
+#ifndef SEGMENTINDEX_INCLUDED
+#define SEGMENTINDEX_INCLUDED
+
+#include "provided.h"
+#include "StreetGraph.h"
+
+#include <vector>
+
+// Uniform grid over the street segments of a StreetGraph, for finding the
+// segment nearest to any point. Each segment is listed in every cell that its
+// bounding box overlaps, and cells are searched in rings around the point
+// until no unsearched cell could hold anything nearer.
+//
+// Distances are measured on a flat projection of the map, with longitude
+// scaled by the cosine of the map's middle latitude, which is accurate to a
+// fraction of a percent over a city.
+class SegmentIndex {
+ public:
+  SegmentIndex();
+
+  // Index the segments of the given graph, which must outlive the index.
+  void build(const StreetGraph &graph);
+  // Find the segment nearest to gc that is at most the given number of miles
+  // away, and the point on it nearest to gc. Returns the segment's index in
+  // the graph, or -1 if there is no segment that near.
+  int findNearest(const GeoCoord &gc, double max_miles,
+                  GeoCoord &snapped) const;
+
+  // We prevent a SegmentIndex object from being copied or assigned.
+  SegmentIndex(const SegmentIndex &) = delete;
+  SegmentIndex &operator=(const SegmentIndex &) = delete;
+
+ private:
+  // Points in projected space, measured in degrees of latitude from the
+  // corner of the map.
+  struct Point {
+    double x, y;
+  };
+
+  Point project(const GeoCoord &gc) const;
+  int column(double x) const;
+  int row(double y) const;
+  // Squared distance from p to the nearest point of a segment, and the
+  // fraction of the way along the segment that the nearest point lies.
+  double distanceToSegment(const Point &p, int segment, double &along) const;
+
+  const StreetGraph *graph_;
+  double min_latitude_, min_longitude_;
+  double longitude_scale_;
+  double cell_size_;
+  int columns_, rows_;
+  std::vector<int> first_entry_;  // Segments in cell i are entries
+                                  // [first_entry_[i], first_entry_[i + 1]).
+  std::vector<int> entries_;
+};
+
+#endif  // SEGMENTINDEX_INCLUDED
@@ -1,7 +1,11 @@
 #include "provided.h"
 #include "support.h"
-#include "MyMap.h"
+#include "MyFlatMap.h"
 
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -13,9 +17,8 @@ class SegmentMapperImpl {
   vector<StreetSegment> getSegments(const GeoCoord &gc) const;
 
  private:
-  void addPOI(const GeoCoord &gc, const StreetSegment &segment);
-
-  MyMap<GeoCoord, vector<StreetSegment>> segments_map_;
+  // Filled once by init and only searched after that.
+  MyFlatMap<GeoCoord, vector<StreetSegment>> segments_map_;
 };
 
 SegmentMapperImpl::SegmentMapperImpl() {}
@@ -23,23 +26,34 @@ SegmentMapperImpl::SegmentMapperImpl() {}
 SegmentMapperImpl::~SegmentMapperImpl() {}
 
 void SegmentMapperImpl::init(const MapLoader &ml) {
-  // Associate all street segments and attraction geocoords with any
-  // geocoordinates that they are associated with.
-  for (int i = 0; i < ml.getNumSegments(); i++) {
-    StreetSegment current_segment;
+  // Note every geocoordinate that each street segment is associated with:
+  // both sides of the segment, and all of the attractions on it.
+  vector<StreetSegment> segments(ml.getNumSegments());
+  vector<pair<GeoCoord, int>> points;
+  for (int i = 0; i < segments.size(); i++) {
+    StreetSegment &current_segment = segments.at(i);
     if (!ml.getSegment(i, current_segment))
       cerr << "Street DNE @ num " << i << endl;
 
-    // Associate both sides of the street segment with the street.
-    addPOI(current_segment.segment.start, current_segment);
-    addPOI(current_segment.segment.end, current_segment);
-
-    // Also associate all coordinates of attractions at that street segment with
-    // the street segment.
-    for (int i = 0; i < current_segment.attractions.size(); i++) {
-      addPOI(current_segment.attractions.at(i).geocoordinates, current_segment);
+    points.push_back(make_pair(current_segment.segment.start, i));
+    points.push_back(make_pair(current_segment.segment.end, i));
+    for (int j = 0; j < current_segment.attractions.size(); j++) {
+      points.push_back(
+          make_pair(current_segment.attractions.at(j).geocoordinates, i));
     }
   }
+
+  // Sort the geocoordinates once, gather the segments at each of them in map
+  // order, and lay the whole index out in one go.
+  sort(points.begin(), points.end());
+  vector<pair<GeoCoord, vector<StreetSegment>>> entries;
+  for (int i = 0; i < points.size(); i++) {
+    if (entries.empty() || !(entries.back().first == points.at(i).first))
+      entries.push_back(make_pair(points.at(i).first, vector<StreetSegment>()));
+    entries.back().second.push_back(segments.at(points.at(i).second));
+  }
+  segments_map_.assign(make_move_iterator(entries.begin()),
+                       make_move_iterator(entries.end()));
 }
 
 vector<StreetSegment> SegmentMapperImpl::getSegments(const GeoCoord &gc) const {
@@ -53,25 +67,6 @@ vector<StreetSegment> SegmentMapperImpl::getSegments(const GeoCoord &gc) const {
   return *segments;
 }
 
-void SegmentMapperImpl::addPOI(const GeoCoord &gc,
-                               const StreetSegment &segment) {
-  vector<StreetSegment> *segments = segments_map_.find(gc);
-
-  // If no street segments exists at the given coordinate, create a vector and
-  // push back the given street segment.
-  if (segments == nullptr) {
-    vector<StreetSegment> new_segments;
-    new_segments.push_back(segment);
-    segments_map_.associate(gc, new_segments);
-
-    return;
-  }
-
-  // Street segments already exist at the given coordinate (intersection?), so
-  // append this new segment to that list.
-  segments->push_back(segment);
-}
-
 //******************** SegmentMapper functions ********************************
 
 // These functions simply delegate to SegmentMapperImpl's functions.
@@ -0,0 +1,367 @@
+#include "StreetGraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// ////////////////////////////// StreetGraph //////////////////////////////////
+StreetGraph::StreetGraph() {}
+
+void StreetGraph::build(const MapLoader &ml) {
+  node_ids_.clear();
+  coords_.clear();
+  edges_.clear();
+  segments_.clear();
+  segment_start_.clear();
+  segment_end_.clear();
+
+  vector<Link> links;
+  MyMap<GeoCoord, int> node_ids;
+
+  // Give every distinct segment endpoint a node number, and join the two ends
+  // of every segment.
+  for (int i = 0; i < ml.getNumSegments(); i++) {
+    StreetSegment current_segment;
+    if (!ml.getSegment(i, current_segment))
+      cerr << "Street DNE @ num " << i << endl;
+
+    int start = addNode(current_segment.segment.start, node_ids);
+    int end = addNode(current_segment.segment.end, node_ids);
+    links.push_back(Link{start, end, i});
+
+    segments_.push_back(current_segment);
+    segment_start_.push_back(start);
+    segment_end_.push_back(end);
+  }
+
+  // An attraction that sits exactly on an intersection, or at the same spot
+  // as an attraction on another street, joins the streets it is on there
+  // (the SegmentMapper lists every one of them at that coordinate). Such
+  // attractions become nodes, joined to both ends of their own segment.
+  MyMap<GeoCoord, int> attraction_segment;  // Segment, or -1 if several.
+  for (int i = 0; i < segments_.size(); i++) {
+    for (int j = 0; j < segments_[i].attractions.size(); j++) {
+      const GeoCoord &gc = segments_[i].attractions[j].geocoordinates;
+      int &segment = attraction_segment.findOrInsert(gc, i);
+      if (segment != i) segment = -1;
+    }
+  }
+
+  for (int i = 0; i < segments_.size(); i++) {
+    for (int j = 0; j < segments_[i].attractions.size(); j++) {
+      const GeoCoord &gc = segments_[i].attractions[j].geocoordinates;
+      if (node_ids.find(gc) == nullptr && *attraction_segment.find(gc) >= 0)
+        continue;
+
+      int node = addNode(gc, node_ids);
+      if (node == segment_start_[i] || node == segment_end_[i]) continue;
+
+      links.push_back(Link{node, segment_start_[i], i});
+      links.push_back(Link{node, segment_end_[i], i});
+    }
+  }
+
+  renumberNodes(links);
+
+  // Lay the edges out so that the edges of each node are contiguous, with
+  // first_edge_ pointing at where each node's run of edges begins.
+  first_edge_.assign(coords_.size() + 1, 0);
+  for (int i = 0; i < links.size(); i++) {
+    first_edge_[links[i].from + 1]++;
+    first_edge_[links[i].to + 1]++;
+  }
+  for (int i = 0; i < coords_.size(); i++)
+    first_edge_[i + 1] += first_edge_[i];
+
+  vector<int> next_edge(first_edge_.begin(), first_edge_.end() - 1);
+  edges_.resize(first_edge_.back());
+  for (int i = 0; i < links.size(); i++) {
+    const Link &link = links[i];
+    double length = distanceEarthMiles(coords_[link.from], coords_[link.to]);
+
+    edges_[next_edge[link.from]++] = Edge{link.to, link.segment, length};
+    edges_[next_edge[link.to]++] = Edge{link.from, link.segment, length};
+  }
+}
+
+int StreetGraph::getNumNodes() const { return coords_.size(); }
+
+int StreetGraph::getNumSegments() const { return segments_.size(); }
+
+const GeoCoord &StreetGraph::getCoord(int node) const { return coords_[node]; }
+
+const StreetSegment &StreetGraph::getSegment(int segment) const {
+  return segments_[segment];
+}
+
+int StreetGraph::getSegmentStart(int segment) const {
+  return segment_start_[segment];
+}
+
+int StreetGraph::getSegmentEnd(int segment) const {
+  return segment_end_[segment];
+}
+
+const StreetGraph::Edge *StreetGraph::edgesBegin(int node) const {
+  return edges_.data() + first_edge_[node];
+}
+
+const StreetGraph::Edge *StreetGraph::edgesEnd(int node) const {
+  return edges_.data() + first_edge_[node + 1];
+}
+
+int StreetGraph::findNode(const GeoCoord &gc) const {
+  const int *node = node_ids_.find(gc);
+  if (node == nullptr) return -1;
+
+  return *node;
+}
+
+int StreetGraph::findSegment(const StreetSegment &segment) const {
+  int start = findNode(segment.segment.start);
+  if (start < 0) return -1;
+
+  // The segment must be one of the edges leaving its starting node.
+  for (const Edge *e = edgesBegin(start); e != edgesEnd(start); e++) {
+    const StreetSegment &candidate = segments_[e->segment];
+    if (candidate.segment == segment.segment &&
+        candidate.streetName == segment.streetName)
+      return e->segment;
+  }
+
+  return -1;
+}
+
+void StreetGraph::getAccess(const GeoCoord &gc,
+                            const vector<StreetSegment> &segments,
+                            vector<Access> &access) const {
+  for (int i = 0; i < segments.size(); i++) {
+    int segment = findSegment(segments[i]);
+    if (segment < 0) continue;
+
+    // The point can leave the segment through either of its ends.
+    int start = segment_start_[segment], end = segment_end_[segment];
+    access.push_back(
+        Access{start, segment, distanceEarthMiles(gc, coords_[start])});
+    access.push_back(
+        Access{end, segment, distanceEarthMiles(gc, coords_[end])});
+  }
+}
+
+void StreetGraph::renumberNodes(vector<Link> &links) {
+  if (coords_.empty()) return;
+
+  // Scale coordinates onto a grid over the map's bounding box.
+  double min_latitude = coords_[0].latitude, max_latitude = min_latitude;
+  double min_longitude = coords_[0].longitude, max_longitude = min_longitude;
+  for (int i = 1; i < coords_.size(); i++) {
+    min_latitude = min(min_latitude, coords_[i].latitude);
+    max_latitude = max(max_latitude, coords_[i].latitude);
+    min_longitude = min(min_longitude, coords_[i].longitude);
+    max_longitude = max(max_longitude, coords_[i].longitude);
+  }
+  double scale = (kHilbertSide - 1) / max(max_latitude - min_latitude,
+                                          max_longitude - min_longitude);
+  if (!(scale < numeric_limits<double>::infinity())) scale = 0;
+
+  vector<pair<uint64_t, int>> order(coords_.size());
+  for (int i = 0; i < coords_.size(); i++) {
+    uint32_t x = (coords_[i].longitude - min_longitude) * scale;
+    uint32_t y = (coords_[i].latitude - min_latitude) * scale;
+    order[i] = make_pair(hilbertIndex(x, y), i);
+  }
+  sort(order.begin(), order.end());
+
+  // Move every per-node array over to the new numbers.
+  vector<int> new_id(coords_.size());
+  vector<GeoCoord> coords(coords_.size());
+  for (int i = 0; i < order.size(); i++) {
+    new_id[order[i].second] = i;
+    coords[i] = coords_[order[i].second];
+  }
+  coords_.swap(coords);
+
+  // Coordinates are looked up on every query, so lay their index out for
+  // searching now that it is complete.
+  vector<pair<GeoCoord, int>> node_ids(coords_.size());
+  for (int i = 0; i < coords_.size(); i++)
+    node_ids[i] = make_pair(coords_[i], i);
+  node_ids_.assign(node_ids.begin(), node_ids.end());
+  for (int i = 0; i < segments_.size(); i++) {
+    segment_start_[i] = new_id[segment_start_[i]];
+    segment_end_[i] = new_id[segment_end_[i]];
+  }
+  for (int i = 0; i < links.size(); i++) {
+    links[i].from = new_id[links[i].from];
+    links[i].to = new_id[links[i].to];
+  }
+}
+
+uint64_t StreetGraph::hilbertIndex(uint32_t x, uint32_t y) {
+  // Work down from the largest quadrants, adding up how far along the curve
+  // each quadrant starts, and rotating the rest of the point into the
+  // orientation that the curve has within the quadrant.
+  uint64_t index = 0;
+  for (uint32_t side = kHilbertSide / 2; side > 0; side /= 2) {
+    uint32_t right = (x & side) != 0, top = (y & side) != 0;
+    index += static_cast<uint64_t>(side) * side * ((3 * right) ^ top);
+
+    if (top == 0) {
+      if (right == 1) {
+        x = kHilbertSide - 1 - x;
+        y = kHilbertSide - 1 - y;
+      }
+      swap(x, y);
+    }
+  }
+
+  return index;
+}
+
+int StreetGraph::addNode(const GeoCoord &gc, MyMap<GeoCoord, int> &node_ids) {
+  int node = node_ids.findOrInsert(gc, coords_.size());
+  if (node == coords_.size()) coords_.push_back(gc);
+  return node;
+}
+
+// ////////////////////////////// SearchTree ///////////////////////////////////
+const int SearchTree::kNoParent;
+
+SearchTree::SearchTree()
+    : graph_(nullptr), search_(0), bound_(0), has_target_(false) {
+  NAV_STAT(stats_ = nullptr);
+}
+
+void SearchTree::reset(const StreetGraph &graph, double bound) {
+  // Start a new search. Node states from earlier searches are left in place
+  // and treated as unreached, except when the stamp wraps around and an old
+  // stamp could be mistaken for the new one.
+  if (++search_ == 0) {
+    nodes_.clear();
+    search_ = 1;
+  }
+
+  nodes_.resize(graph.getNumNodes(),
+                NodeState{numeric_limits<double>::infinity(), kNoParent,
+                          kNoParent, 0, false});
+  to_settle_.clear();
+  graph_ = &graph;
+  bound_ = bound;
+  has_target_ = false;
+  NAV_STAT(stats_ = nullptr);
+}
+
+void SearchTree::setTarget(const GeoCoord &target) {
+  // Straight-line distance never overestimates the distance along streets
+  // (each segment is itself measured in a straight line), so A* still
+  // settles every node at its true distance.
+  has_target_ = true;
+  target_ = target;
+}
+
+void SearchTree::setStats(NavStats *stats) { NAV_STAT(stats_ = stats); }
+
+void SearchTree::seed(const StreetGraph::Access &access) {
+  if (access.length > bound_) return;
+
+  NodeState &node = state(access.node);
+  if (access.length >= node.distance) return;
+
+  node.distance = access.length;
+  node.parent = kNoParent;
+  node.parent_segment = access.segment;
+  enqueue(access.node, access.length);
+}
+
+int SearchTree::settleNext() {
+  while (!to_settle_.empty()) {
+    int node = to_settle_.front().second;
+    pop_heap(to_settle_.begin(), to_settle_.end(), greater<QueueEntry>());
+    to_settle_.pop_back();
+
+    // Skip queue entries that were superseded by a shorter distance.
+    NodeState &current = nodes_[node];
+    if (current.settled) continue;
+    current.settled = true;
+    NAV_STAT(if (stats_ != nullptr) stats_->nodes_popped++);
+
+    for (const StreetGraph::Edge *e = graph_->edgesBegin(node);
+         e != graph_->edgesEnd(node); e++) {
+      double distance = current.distance + e->length;
+      if (distance > bound_) continue;
+
+      NodeState &next = state(e->to);
+      if (distance >= next.distance) continue;
+
+      next.distance = distance;
+      next.parent = node;
+      next.parent_segment = e->segment;
+      enqueue(e->to, distance);
+    }
+
+    return node;
+  }
+
+  return -1;
+}
+
+double SearchTree::peekDistance() {
+  // Drop stale entries so that the top of the queue is a real candidate.
+  while (!to_settle_.empty() && nodes_[to_settle_.front().second].settled) {
+    pop_heap(to_settle_.begin(), to_settle_.end(), greater<QueueEntry>());
+    to_settle_.pop_back();
+  }
+
+  if (to_settle_.empty()) return numeric_limits<double>::infinity();
+  return to_settle_.front().first;
+}
+
+bool SearchTree::reached(int node) const {
+  return nodes_[node].search == search_;
+}
+
+bool SearchTree::settled(int node) const {
+  return reached(node) && nodes_[node].settled;
+}
+
+double SearchTree::getDistance(int node) const {
+  if (!reached(node)) return numeric_limits<double>::infinity();
+  return nodes_[node].distance;
+}
+
+int SearchTree::getParent(int node) const {
+  if (!reached(node)) return kNoParent;
+  return nodes_[node].parent;
+}
+
+int SearchTree::getParentSegment(int node) const {
+  if (!reached(node)) return kNoParent;
+  return nodes_[node].parent_segment;
+}
+
+void SearchTree::enqueue(int node, double distance) {
+  double priority = distance;
+  if (has_target_)
+    priority += distanceEarthMiles(graph_->getCoord(node), target_);
+
+  to_settle_.push_back(QueueEntry(priority, node));
+  push_heap(to_settle_.begin(), to_settle_.end(), greater<QueueEntry>());
+
+  NAV_STAT(if (stats_ != nullptr) {
+    stats_->edges_relaxed++;
+    stats_->heap_peak = max<long>(stats_->heap_peak, to_settle_.size());
+  });
+}
+
+SearchTree::NodeState &SearchTree::state(int node) {
+  NodeState &current = nodes_[node];
+  if (current.search != search_) {
+    current = NodeState{numeric_limits<double>::infinity(), kNoParent,
+                        kNoParent, search_, false};
+  }
+
+  return current;
+}
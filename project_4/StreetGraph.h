@@ -0,0 +1,159 @@
+#ifndef STREETGRAPH_INCLUDED
+#define STREETGRAPH_INCLUDED
+
+#include "provided.h"
+#include "support.h"
+#include "MyFlatMap.h"
+#include "MyMap.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Compact adjacency-array form of the street network, built once from a
+// loaded map. Every distinct street segment endpoint becomes a node, and every
+// street segment becomes an undirected edge between its two endpoints. Nodes
+// are numbered in order along a Hilbert curve over their coordinates, so that
+// nodes near each other on the map are also near each other in memory, and a
+// search touches as few cache lines as it can.
+// Attractions are mostly not nodes; they sit part of the way along a segment
+// and are connected to its endpoints when a query starts or ends at them. The
+// exception is an attraction at the same spot as an intersection or as an
+// attraction on another street, which is a node joined to both ends of its
+// segment so that routes can change streets there.
+class StreetGraph {
+ public:
+  struct Edge {
+    int to;          // Node at the other end of the edge.
+    int segment;     // Index of the street segment in the loaded map.
+    double length;   // Length of the edge in miles.
+  };
+
+  // A way onto (or off of) the graph from a point that lies on a segment.
+  struct Access {
+    int node;        // Endpoint of the segment.
+    int segment;     // Segment that the point lies on.
+    double length;   // Distance between the point and the endpoint in miles.
+  };
+
+  StreetGraph();
+  void build(const MapLoader &ml);
+
+  int getNumNodes() const;
+  int getNumSegments() const;
+  const GeoCoord &getCoord(int node) const;
+  const StreetSegment &getSegment(int segment) const;
+  int getSegmentStart(int segment) const;
+  int getSegmentEnd(int segment) const;
+  const Edge *edgesBegin(int node) const;
+  const Edge *edgesEnd(int node) const;
+
+  // Return the node at the given coordinate, or -1 if no segment ends there.
+  int findNode(const GeoCoord &gc) const;
+  // Return the index of the given street segment, or -1 if it is not part of
+  // the graph.
+  int findSegment(const StreetSegment &segment) const;
+  // Append the ways of reaching the endpoints of each of the given segments
+  // from a point that lies on them.
+  void getAccess(const GeoCoord &gc, const std::vector<StreetSegment> &segments,
+                 std::vector<Access> &access) const;
+
+  // We prevent a StreetGraph object from being copied or assigned.
+  StreetGraph(const StreetGraph &) = delete;
+  StreetGraph &operator=(const StreetGraph &) = delete;
+
+ private:
+  // Undirected edges, collected before they are laid out by node.
+  struct Link {
+    int from, to, segment;
+  };
+
+  // Points per side of the grid that nodes are placed on for ordering.
+  static const uint32_t kHilbertSide = 1 << 16;
+
+  // Give a coordinate a node number while the graph is being built.
+  int addNode(const GeoCoord &gc, MyMap<GeoCoord, int> &node_ids);
+  // Renumber the nodes along the Hilbert curve.
+  void renumberNodes(std::vector<Link> &links);
+  // Distance along the Hilbert curve that fills the grid to a grid point.
+  static uint64_t hilbertIndex(uint32_t x, uint32_t y);
+
+  MyFlatMap<GeoCoord, int> node_ids_;  // Laid out once nodes are numbered.
+  std::vector<GeoCoord> coords_;
+  std::vector<int> first_edge_;  // Edges of node i are [first_edge_[i],
+                                 // first_edge_[i + 1]).
+  std::vector<Edge> edges_;
+  std::vector<StreetSegment> segments_;
+  std::vector<int> segment_start_;
+  std::vector<int> segment_end_;
+};
+
+// State of one Dijkstra search over a StreetGraph. The search is seeded with
+// any number of access points and then grown one node at a time, so that two
+// of these can be interleaved for a bidirectional search.
+//
+// A tree is meant to be kept and reused for many searches. Every node's state
+// is stamped with the search that wrote it, so starting a new search only
+// bumps the current stamp instead of clearing an entry for every node.
+class SearchTree {
+ public:
+  static const int kNoParent = -1;
+
+  SearchTree();
+
+  // Forget the previous search and start one over the given graph, which
+  // must outlive the search. Nodes farther than the bound from the seeds are
+  // never queued.
+  void reset(const StreetGraph &graph,
+             double bound = std::numeric_limits<double>::infinity());
+  // Turn the search into an A* search towards the given point, settling nodes
+  // in order of their distance plus their straight-line distance to it.
+  void setTarget(const GeoCoord &target);
+  // Count the work done by the search into the given statistics.
+  void setStats(NavStats *stats);
+  // Start the search at an access node.
+  void seed(const StreetGraph::Access &access);
+  // Settle the closest unsettled node, relax its edges and return it, or
+  // return -1 once every reachable node has been settled.
+  int settleNext();
+  // Distance of the closest node that has not been settled yet, plus its
+  // straight-line distance to the target if there is one, or infinity.
+  double peekDistance();
+
+  bool reached(int node) const;
+  bool settled(int node) const;
+  double getDistance(int node) const;
+  // Node that this node was reached from, or kNoParent for access nodes.
+  int getParent(int node) const;
+  // Segment that this node was reached through.
+  int getParentSegment(int node) const;
+
+ private:
+  typedef std::pair<double, int> QueueEntry;  // Distance and node.
+
+  struct NodeState {
+    double distance;
+    int parent;
+    int parent_segment;
+    unsigned search;  // Search that this state belongs to.
+    bool settled;
+  };
+
+  // Mutable state of the node for the current search, initializing it if it
+  // was last written by an earlier search.
+  NodeState &state(int node);
+  // Queue a node that was reached with a shorter distance.
+  void enqueue(int node, double distance);
+
+  const StreetGraph *graph_;
+  std::vector<NodeState> nodes_;
+  std::vector<QueueEntry> to_settle_;  // Min-heap ordered by distance.
+  unsigned search_;
+  double bound_;
+  bool has_target_;
+  GeoCoord target_;
+  NAV_STAT(NavStats *stats_;)
+};
+
+#endif  // STREETGRAPH_INCLUDED
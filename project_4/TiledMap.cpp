@@ -0,0 +1,379 @@
+#include "TiledMap.h"
+#include "support.h"
+#include "CompactMap.h"
+#include "MyMap.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+static const double kFixedPointScale = 1e7;
+
+static void writeVarint(uint64_t value, string &out) {
+  while (value >= 0x80) {
+    out += static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+static bool readVarint(istream &in, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = in.get();
+    if (byte == EOF) return false;
+
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ (value < 0 ? ~0ULL : 0);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static string toLower(string text) {
+  for (int i = 0; i < text.size(); i++) text[i] = tolower(text[i]);
+  return text;
+}
+
+// Tile that a coordinate falls in, or -1 if it is outside the grid. Writing
+// and reading both go through here, so they always agree.
+static int tileIndex(const GeoCoord &gc, double origin_latitude,
+                     double origin_longitude, double tile_degrees, int columns,
+                     int rows) {
+  double column = floor((gc.longitude - origin_longitude) / tile_degrees);
+  double row = floor((gc.latitude - origin_latitude) / tile_degrees);
+  if (column < 0 || column >= columns || row < 0 || row >= rows) return -1;
+
+  return static_cast<int>(row) * columns + static_cast<int>(column);
+}
+
+// Rough number of bytes that a decoded segment takes up.
+static size_t segmentBytes(const StreetSegment &segment) {
+  auto coordBytes = [](const GeoCoord &gc) {
+    return gc.latitudeText.capacity() + gc.longitudeText.capacity();
+  };
+
+  size_t bytes = sizeof(StreetSegment) + segment.streetName.capacity() +
+                 coordBytes(segment.segment.start) +
+                 coordBytes(segment.segment.end) +
+                 segment.attractions.capacity() * sizeof(Attraction);
+  for (int i = 0; i < segment.attractions.size(); i++) {
+    const Attraction &attraction = segment.attractions[i];
+    bytes += attraction.name.capacity() + coordBytes(attraction.geocoordinates);
+  }
+  return bytes;
+}
+
+bool writeTiledMap(const MapLoader &ml, const string &mapFile,
+                   double tile_degrees) {
+  vector<StreetSegment> segments(ml.getNumSegments());
+  for (int i = 0; i < segments.size(); i++) ml.getSegment(i, segments[i]);
+  if (segments.empty() || !(tile_degrees > 0)) return false;
+
+  // Lay the grid over every coordinate in the map, with its corner and tile
+  // size in fixed point so that they are stored exactly.
+  double min_latitude = segments[0].segment.start.latitude;
+  double max_latitude = min_latitude;
+  double min_longitude = segments[0].segment.start.longitude;
+  double max_longitude = min_longitude;
+  for (int i = 0; i < segments.size(); i++) {
+    vector<const GeoCoord *> coords = {&segments[i].segment.start,
+                                       &segments[i].segment.end};
+    for (int j = 0; j < segments[i].attractions.size(); j++)
+      coords.push_back(&segments[i].attractions[j].geocoordinates);
+
+    for (int j = 0; j < coords.size(); j++) {
+      min_latitude = min(min_latitude, coords[j]->latitude);
+      max_latitude = max(max_latitude, coords[j]->latitude);
+      min_longitude = min(min_longitude, coords[j]->longitude);
+      max_longitude = max(max_longitude, coords[j]->longitude);
+    }
+  }
+
+  int64_t tile_size = max<int64_t>(1, llround(tile_degrees * kFixedPointScale));
+  int64_t origin_latitude = floor(min_latitude * kFixedPointScale) - 1;
+  int64_t origin_longitude = floor(min_longitude * kFixedPointScale) - 1;
+  double tile = tile_size / kFixedPointScale;
+  double latitude = origin_latitude / kFixedPointScale;
+  double longitude = origin_longitude / kFixedPointScale;
+  int columns = floor((max_longitude - longitude) / tile) + 1;
+  int rows = floor((max_latitude - latitude) / tile) + 1;
+
+  // Put each segment in the tile of each of its points, and note the tile of
+  // each attraction. A name that comes up again takes the latest tile, as in
+  // AttractionMapper.
+  vector<vector<StreetSegment>> tiles(columns * rows);
+  vector<string> names;
+  vector<int> name_tiles;
+  MyMap<string, int> name_ids;  // Case-insensitive.
+  for (int i = 0; i < segments.size(); i++) {
+    const StreetSegment &segment = segments[i];
+    vector<int> used = {
+        tileIndex(segment.segment.start, latitude, longitude, tile, columns,
+                  rows),
+        tileIndex(segment.segment.end, latitude, longitude, tile, columns,
+                  rows)};
+
+    for (int j = 0; j < segment.attractions.size(); j++) {
+      const Attraction &attraction = segment.attractions[j];
+      int t = tileIndex(attraction.geocoordinates, latitude, longitude, tile,
+                        columns, rows);
+      used.push_back(t);
+
+      int id = name_ids.findOrInsert(toLower(attraction.name), names.size());
+      if (id != names.size()) {
+        name_tiles[id] = t;
+        continue;
+      }
+      names.push_back(attraction.name);
+      name_tiles.push_back(t);
+    }
+
+    sort(used.begin(), used.end());
+    used.erase(unique(used.begin(), used.end()), used.end());
+    for (int j = 0; j < used.size(); j++) tiles[used[j]].push_back(segment);
+  }
+
+  string out(kTiledMapMagic, kTiledMapMagicLength);
+  writeVarint(tile_size, out);
+  writeVarint(zigzag(origin_latitude), out);
+  writeVarint(zigzag(origin_longitude), out);
+  writeVarint(columns, out);
+  writeVarint(rows, out);
+
+  writeVarint(names.size(), out);
+  for (int i = 0; i < names.size(); i++) {
+    writeVarint(names[i].size(), out);
+    out += names[i];
+    writeVarint(name_tiles[i], out);
+  }
+
+  string blobs;
+  vector<size_t> sizes(tiles.size());
+  for (int i = 0; i < tiles.size(); i++) {
+    size_t start = blobs.size();
+    if (!tiles[i].empty() && !encodeCompactMap(tiles[i], blobs)) return false;
+    sizes[i] = blobs.size() - start;
+  }
+  for (int i = 0; i < sizes.size(); i++) writeVarint(sizes[i], out);
+
+  ofstream file(mapFile, ios::binary);
+  return file.write(out.data(), out.size()) &&
+         file.write(blobs.data(), blobs.size()) && file.flush();
+}
+
+TiledMap::TiledMap()
+    : max_bytes_(0),
+      tile_degrees_(1),
+      origin_latitude_(0),
+      origin_longitude_(0),
+      columns_(0),
+      rows_(0),
+      bytes_held_(0),
+      tiles_read_(0),
+      tiles_dropped_(0) {}
+
+bool TiledMap::open(const string &mapFile, size_t max_bytes) {
+  map_file_ = mapFile;
+  max_bytes_ = max_bytes;
+  columns_ = rows_ = 0;
+  name_tiles_.clear();
+  tiles_.clear();
+  recent_.clear();
+  bytes_held_ = 0;
+  tiles_read_ = tiles_dropped_ = 0;
+
+  ifstream in(mapFile, ios::binary);
+  in.seekg(0, ios::end);
+  uint64_t file_size = in ? static_cast<uint64_t>(in.tellg()) : 0;
+  in.seekg(0);
+  char magic[kTiledMapMagicLength];
+  if (!in.read(magic, kTiledMapMagicLength) ||
+      memcmp(magic, kTiledMapMagic, kTiledMapMagicLength) != 0)
+    return false;
+
+  // Counts read from the file are checked against what is left of it before
+  // anything is sized from them, so that a corrupt file is rejected rather
+  // than run out of memory. Every tile takes at least the byte of its size,
+  // and every name the bytes of its length and tile.
+  auto bytesLeft = [&]() -> uint64_t {
+    return file_size - static_cast<uint64_t>(in.tellg());
+  };
+
+  uint64_t tile_size, origin_latitude, origin_longitude, columns, rows;
+  if (!readVarint(in, tile_size) || !readVarint(in, origin_latitude) ||
+      !readVarint(in, origin_longitude) || !readVarint(in, columns) ||
+      !readVarint(in, rows))
+    return false;
+  if (tile_size == 0 || columns == 0 || rows == 0 ||
+      columns > bytesLeft() / rows || columns * rows > INT_MAX)
+    return false;
+  tile_degrees_ = tile_size / kFixedPointScale;
+  origin_latitude_ = unzigzag(origin_latitude) / kFixedPointScale;
+  origin_longitude_ = unzigzag(origin_longitude) / kFixedPointScale;
+
+  uint64_t num_names;
+  if (!readVarint(in, num_names) || num_names > bytesLeft() / 2) return false;
+  vector<string> names(num_names);
+  name_tiles_.resize(num_names);
+  for (int i = 0; i < num_names; i++) {
+    uint64_t length, tile;
+    if (!readVarint(in, length) || length > bytesLeft()) return false;
+    names[i].resize(length);
+    if (!in.read(&names[i][0], length) || !readVarint(in, tile)) return false;
+    name_tiles_[i] = tile;
+  }
+
+  // Name tiles are stored by the order of the names, and looked up by their
+  // position in the index, which cannot be built if names repeat.
+  if (!names_.build(names)) return false;
+  vector<int> name_tiles(num_names);
+  for (int i = 0; i < num_names; i++)
+    name_tiles[names_.getPosition(i)] = name_tiles_[i];
+  name_tiles_.swap(name_tiles);
+
+  tiles_.resize(columns * rows);
+  for (int i = 0; i < tiles_.size(); i++) {
+    if (!readVarint(in, tiles_[i].size)) return false;
+    tiles_[i].held = false;
+    tiles_[i].bytes = 0;
+  }
+
+  uint64_t offset = in.tellg();
+  for (int i = 0; i < tiles_.size(); i++) {
+    tiles_[i].offset = offset;
+    offset += tiles_[i].size;
+  }
+
+  columns_ = columns;
+  rows_ = rows;
+  return true;
+}
+
+bool TiledMap::getGeoCoord(const string &attraction, GeoCoord &gc) {
+  int position = names_.find(attraction);
+  if (position < 0) return false;
+
+  const Tile *tile = useTile(name_tiles_[position]);
+  if (tile == nullptr) return false;
+
+  // The tile was noted for the latest attraction of this name, and keeps the
+  // map's order, so the last match is the one to give.
+  bool found = false;
+  string name = toLower(attraction);
+  for (int i = 0; i < tile->segments.size(); i++) {
+    const vector<Attraction> &attractions = tile->segments[i].attractions;
+    for (int j = 0; j < attractions.size(); j++) {
+      if (toLower(attractions[j].name) != name) continue;
+      gc = attractions[j].geocoordinates;
+      found = true;
+    }
+  }
+  return found;
+}
+
+vector<StreetSegment> TiledMap::getSegments(const GeoCoord &gc) {
+  vector<StreetSegment> segments;
+  const Tile *tile = useTile(tileOf(gc));
+  if (tile == nullptr) return segments;
+
+  auto less = [](const pair<GeoCoord, int> &point, const GeoCoord &gc) {
+    return point.first < gc;
+  };
+  auto point = lower_bound(tile->points.begin(), tile->points.end(), gc, less);
+  for (int last = -1; point != tile->points.end() && point->first == gc;
+       point++) {
+    // A segment may have several points here, but is only given once.
+    if (point->second == last) continue;
+    last = point->second;
+    segments.push_back(tile->segments[last]);
+  }
+  return segments;
+}
+
+size_t TiledMap::getBytesHeld() const { return bytes_held_; }
+
+int TiledMap::getTilesRead() const { return tiles_read_; }
+
+int TiledMap::getTilesDropped() const { return tiles_dropped_; }
+
+int TiledMap::tileOf(const GeoCoord &gc) const {
+  return tileIndex(gc, origin_latitude_, origin_longitude_, tile_degrees_,
+                   columns_, rows_);
+}
+
+const TiledMap::Tile *TiledMap::useTile(int tile) {
+  if (tile < 0 || tile >= tiles_.size()) return nullptr;
+
+  Tile &t = tiles_[tile];
+  if (t.held) {
+    recent_.splice(recent_.begin(), recent_, t.recent);
+    return &t;
+  }
+
+  CompactMapReader reader;
+  if (t.size > 0) {
+    if (!reader.open(map_file_, t.offset)) return nullptr;
+    t.segments.resize(reader.getNumSegments());
+    for (int i = 0; i < t.segments.size(); i++) {
+      if (!reader.next(t.segments[i])) {
+        t.segments.clear();
+        return nullptr;
+      }
+    }
+  }
+
+  t.points.clear();
+  t.bytes = sizeof(Tile);
+  for (int i = 0; i < t.segments.size(); i++) {
+    const StreetSegment &segment = t.segments[i];
+    t.points.push_back(make_pair(segment.segment.start, i));
+    t.points.push_back(make_pair(segment.segment.end, i));
+    for (int j = 0; j < segment.attractions.size(); j++)
+      t.points.push_back(make_pair(segment.attractions[j].geocoordinates, i));
+    t.bytes += segmentBytes(segment);
+  }
+  sort(t.points.begin(), t.points.end());
+  for (int i = 0; i < t.points.size(); i++) {
+    t.bytes += sizeof(t.points[i]) + t.points[i].first.latitudeText.capacity() +
+               t.points[i].first.longitudeText.capacity();
+  }
+
+  t.held = true;
+  recent_.push_front(tile);
+  t.recent = recent_.begin();
+  bytes_held_ += t.bytes;
+  tiles_read_++;
+
+  // Drop the least recently used tiles until the rest fit, never dropping
+  // the tile that was just read.
+  while (bytes_held_ > max_bytes_ && recent_.size() > 1)
+    dropTile(recent_.back());
+
+  return &t;
+}
+
+void TiledMap::dropTile(int tile) {
+  Tile &t = tiles_[tile];
+  recent_.erase(t.recent);
+  bytes_held_ -= t.bytes;
+  tiles_dropped_++;
+
+  // Swap the contents away so that their memory is given back.
+  vector<StreetSegment>().swap(t.segments);
+  vector<pair<GeoCoord, int>>().swap(t.points);
+  t.bytes = 0;
+  t.held = false;
+}
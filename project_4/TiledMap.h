@@ -0,0 +1,95 @@
+#ifndef TILEDMAP_INCLUDED
+#define TILEDMAP_INCLUDED
+
+#include "provided.h"
+#include "NameIndex.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Map split into square geographic tiles, each stored as a separate compact
+// map (see CompactMap.h) so that it can be read on its own. A segment is
+// stored in the tile of each of its ends and of each of its attractions, so
+// the tile of any coordinate holds every segment that a SegmentMapper would
+// give for it.
+//
+//  magic            "BNT1"
+//  tile size        varint, in ten-millionths of a degree
+//  origin           two signed varints (latitude, longitude) of the corner
+//  columns, rows    varints
+//  attractions      varint, followed by that many (length varint, bytes,
+//                   tile varint), giving the tile that each name is in
+//  tile sizes       varint per tile in row order, zero for empty tiles
+//  tiles            the compact map of each tile, back to back
+const char kTiledMapMagic[] = "BNT1";
+const int kTiledMapMagicLength = 4;
+
+// Write the segments of a loaded map as a tiled map with tiles of the given
+// size in degrees. Fails under the same conditions as writeCompactMap.
+bool writeTiledMap(const MapLoader &ml, const std::string &mapFile,
+                   double tile_degrees);
+
+// Reads a tiled map a tile at a time, keeping the most recently used tiles
+// in memory. Only the attraction names and the tile directory stay loaded
+// for good; tiles are read when a lookup first needs them and dropped, least
+// recently used first, once the tiles held take more than a set number of
+// bytes.
+class TiledMap {
+ public:
+  TiledMap();
+
+  // Open a tiled map, holding at most about max_bytes of tiles at a time. At
+  // least one tile is always held, whatever its size. Returns false if the
+  // file is cut short or corrupt, including when its header or names claim
+  // more than the rest of the file could hold, or two of its names are equal
+  // ignoring case.
+  bool open(const std::string &mapFile, size_t max_bytes);
+  bool getGeoCoord(const std::string &attraction, GeoCoord &gc);
+  std::vector<StreetSegment> getSegments(const GeoCoord &gc);
+
+  // Bytes of tiles held now, and tiles read and dropped since open.
+  size_t getBytesHeld() const;
+  int getTilesRead() const;
+  int getTilesDropped() const;
+
+  // We prevent a TiledMap object from being copied or assigned.
+  TiledMap(const TiledMap &) = delete;
+  TiledMap &operator=(const TiledMap &) = delete;
+
+ private:
+  struct Tile {
+    uint64_t offset;  // Where its compact map starts in the file.
+    uint64_t size;    // Zero for a tile with no segments.
+    bool held;
+    std::vector<StreetSegment> segments;
+    // Every end and attraction coordinate with the segment it belongs to,
+    // sorted by coordinate.
+    std::vector<std::pair<GeoCoord, int>> points;
+    size_t bytes;
+    std::list<int>::iterator recent;  // Place in recent_ while held.
+  };
+
+  int tileOf(const GeoCoord &gc) const;
+  // Make the tile held and most recently used, reading it if need be. Returns
+  // nullptr if it cannot be read.
+  const Tile *useTile(int tile);
+  void dropTile(int tile);
+
+  std::string map_file_;
+  size_t max_bytes_;
+  double tile_degrees_;
+  double origin_latitude_, origin_longitude_;
+  int columns_, rows_;
+  NameIndex names_;
+  std::vector<int> name_tiles_;  // By position in names_.
+  std::vector<Tile> tiles_;
+  std::list<int> recent_;  // Tiles held, most recently used first.
+  size_t bytes_held_;
+  int tiles_read_;
+  int tiles_dropped_;
+};
+
+#endif  // TILEDMAP_INCLUDED
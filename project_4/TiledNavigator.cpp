@@ -0,0 +1,106 @@
+#include "TiledNavigator.h"
+#include "support.h"
+#include "Directions.h"
+#include "MyMap.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+using namespace std;
+
+TiledNavigator::TiledNavigator() {}
+
+bool TiledNavigator::loadMapData(const string &mapFile, size_t max_bytes) {
+  return map_.open(mapFile, max_bytes);
+}
+
+NavResult TiledNavigator::navigate(const string &start, const string &end,
+                                   vector<NavSegment> &directions) {
+  GeoCoord src, dst;
+  directions.clear();
+  if (!map_.getGeoCoord(start, src)) return NAV_BAD_SOURCE;
+  if (!map_.getGeoCoord(end, dst)) return NAV_BAD_DESTINATION;
+
+  // How each point was reached: from which point, along which street.
+  struct Visit {
+    double distance;
+    GeoCoord parent;
+    string street;
+    bool settled;
+  };
+  MyMap<GeoCoord, Visit> visits;
+
+  // A* over coordinates, from any point of a segment to either of its ends or
+  // any attraction on it, ordered by the distance so far plus the straight-
+  // line distance left.
+  typedef pair<double, GeoCoord> QueueEntry;
+  priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> to_visit;
+  visits.associate(src, Visit{0, src, "", false});
+  to_visit.push(QueueEntry(distanceEarthMiles(src, dst), src));
+
+  bool found = false;
+  while (!to_visit.empty()) {
+    GeoCoord coord = to_visit.top().second;
+    to_visit.pop();
+
+    Visit *visit = visits.find(coord);
+    if (visit->settled) continue;
+    visit->settled = true;
+    double distance = visit->distance;
+    found = coord == dst;
+    if (found) break;
+
+    vector<StreetSegment> segments = map_.getSegments(coord);
+    for (int i = 0; i < segments.size(); i++) {
+      const StreetSegment &segment = segments[i];
+      vector<const GeoCoord *> next = {&segment.segment.start,
+                                       &segment.segment.end};
+      for (int j = 0; j < segment.attractions.size(); j++)
+        next.push_back(&segment.attractions[j].geocoordinates);
+
+      for (int j = 0; j < next.size(); j++) {
+        double d = distance + distanceEarthMiles(coord, *next[j]);
+        Visit *known = visits.find(*next[j]);
+        if (known != nullptr && (known->settled || known->distance <= d))
+          continue;
+
+        Visit reached{d, coord, segment.streetName, false};
+        if (known != nullptr)
+          *known = reached;
+        else
+          visits.associate(*next[j], reached);
+        to_visit.push(QueueEntry(d + distanceEarthMiles(*next[j], dst),
+                                 *next[j]));
+      }
+    }
+  }
+
+  if (!found) return NAV_NO_ROUTE;
+
+  // Walk back from the destination, one leg per step.
+  vector<NavSegment> legs;
+  for (GeoCoord coord = dst; !(coord == src);) {
+    const Visit *visit = visits.find(coord);
+    legs.push_back(NavSegment("", visit->street,
+                              distanceEarthMiles(visit->parent, coord),
+                              GeoSegment(visit->parent, coord)));
+    coord = visit->parent;
+  }
+  reverse(legs.begin(), legs.end());
+
+  // A route from an attraction to itself has no legs, but still gets a
+  // proceed, as Navigator gives.
+  if (legs.empty()) {
+    vector<StreetSegment> segments = map_.getSegments(src);
+    if (segments.empty()) return NAV_NO_ROUTE;
+    legs.push_back(NavSegment("", segments.front().streetName, 0,
+                              GeoSegment(src, dst)));
+  }
+
+  makeDirections(legs, false, directions);
+  return NAV_SUCCESS;
+}
+
+const TiledMap &TiledNavigator::getMap() const { return map_; }
@@ -0,0 +1,35 @@
+#ifndef TILEDNAVIGATOR_INCLUDED
+#define TILEDNAVIGATOR_INCLUDED
+
+#include "provided.h"
+#include "TiledMap.h"
+
+#include <string>
+#include <vector>
+
+// Navigator over a tiled map (see TiledMap.h), for maps too large to load
+// whole. Nothing is built over the map up front: the search asks the tile
+// cache for the segments at each point it reaches, so only the tiles around
+// the route are read, and the tiles held stay within the cache's limit
+// however large the map is. The search's own visited points and queue are
+// not bounded by the cache, and grow with the area the search covers.
+class TiledNavigator {
+ public:
+  TiledNavigator();
+
+  // Open a tiled map, holding at most about max_bytes of tiles at a time.
+  bool loadMapData(const std::string &mapFile, size_t max_bytes);
+  // Find the shortest route between two attractions, as Navigator does.
+  NavResult navigate(const std::string &start, const std::string &end,
+                     std::vector<NavSegment> &directions);
+  const TiledMap &getMap() const;
+
+  // We prevent a TiledNavigator object from being copied or assigned.
+  TiledNavigator(const TiledNavigator &) = delete;
+  TiledNavigator &operator=(const TiledNavigator &) = delete;
+
+ private:
+  TiledMap map_;
+};
+
+#endif  // TILEDNAVIGATOR_INCLUDED
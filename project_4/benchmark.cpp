@@ -0,0 +1,410 @@
+// Benchmark for BruinNav. Loads a map, draws a reproducible set of random
+// attraction pairs and times every kind of query the Navigator answers on
+// them, after timing the lookup of every attraction name. Coordinate queries
+// use points scattered around the same attractions. Run it with
+//  ./BruinNavBench [mapdata.txt] [-queries N] [-seed S]
+//                  [-tiles mapdata.bnt] [-tile-cache KB]
+// to also time routes over a tiled copy of the map with a bounded tile cache.
+// The results are printed as CSV, one row per query mode, so that runs can be
+// compared against each other to catch regressions. Cache misses are counted
+// with the hardware performance counters on Linux systems that provide them,
+// and left blank elsewhere.
+
+#include "provided.h"
+#include "TiledNavigator.h"
+
+#include <sys/resource.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct QueryPair {
+  string start;
+  string end;
+  GeoCoord start_point;  // Near the start attraction.
+  GeoCoord end_point;    // Near the end attraction.
+};
+
+typedef NavResult (*QueryFunction)(const Navigator &nav, const QueryPair &q);
+
+NavResult runNavigate(const Navigator &nav, const QueryPair &q) {
+  vector<NavSegment> directions;
+  return nav.navigate(q.start, q.end, directions);
+}
+
+NavResult runNavigateCoordinates(const Navigator &nav, const QueryPair &q) {
+  vector<NavSegment> directions;
+  return nav.navigate(q.start_point, q.end_point, directions);
+}
+
+NavResult runAlternatives(const Navigator &nav, const QueryPair &q) {
+  vector<vector<NavSegment>> routes;
+  return nav.navigateAlternatives(q.start, q.end, 3, routes);
+}
+
+NavResult runReachable(const Navigator &nav, const QueryPair &q) {
+  Isochrone area;
+  return nav.reachableWithin(q.start, 1.0, area);
+}
+
+// Hardware counts of cache references and misses by this process.
+class CacheCounters {
+ public:
+  CacheCounters() : references_(-1), misses_(-1) {
+#ifdef __linux__
+    references_ = open(PERF_COUNT_HW_CACHE_REFERENCES);
+    misses_ = open(PERF_COUNT_HW_CACHE_MISSES);
+#endif
+  }
+
+  ~CacheCounters() {
+#ifdef __linux__
+    if (references_ >= 0) close(references_);
+    if (misses_ >= 0) close(misses_);
+#endif
+  }
+
+  bool available() const { return references_ >= 0 && misses_ >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (!available()) return;
+    ioctl(references_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(misses_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(references_, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(misses_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  // Stop counting, and give the counts since start.
+  void stop(long long &references, long long &misses) {
+    references = misses = 0;
+#ifdef __linux__
+    if (!available()) return;
+    ioctl(references_, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(misses_, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(references_, &references, sizeof(references)) < 0 ||
+        read(misses_, &misses, sizeof(misses)) < 0)
+      references = misses = 0;
+#endif
+  }
+
+ private:
+#ifdef __linux__
+  static int open(unsigned long long event) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = event;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+#endif
+
+  int references_;
+  int misses_;
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Peak resident set size of this process so far, in kilobytes.
+long peakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;  // Reported in bytes on macOS.
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+vector<string> loadAttractionNames(const string &map_file) {
+  MapLoader ml;
+  vector<string> names;
+  if (!ml.load(map_file)) return names;
+
+  for (int i = 0; i < ml.getNumSegments(); i++) {
+    StreetSegment segment;
+    ml.getSegment(i, segment);
+    for (int j = 0; j < segment.attractions.size(); j++)
+      names.push_back(segment.attractions.at(j).name);
+  }
+
+  return names;
+}
+
+// Draw pairs of attractions with a fixed generator. The raw output of
+// mt19937 is fully specified by the standard, unlike its distributions, so
+// the same seed gives the same pairs with every compiler.
+vector<QueryPair> samplePairs(const vector<string> &names, int count,
+                              unsigned seed) {
+  mt19937 generator(seed);
+  vector<QueryPair> pairs;
+
+  for (int i = 0; i < count; i++) {
+    const string &start = names.at(generator() % names.size());
+    const string &end = names.at(generator() % names.size());
+    pairs.push_back(QueryPair{start, end});
+  }
+
+  return pairs;
+}
+
+// Place the points of each pair at up to a couple of hundred yards from their
+// attractions, in a direction drawn with the same kind of generator.
+void scatterPoints(const string &map_file, vector<QueryPair> &pairs,
+                   unsigned seed) {
+  const double kMaxOffset = 0.002;  // Degrees.
+
+  MapLoader ml;
+  ml.load(map_file);
+  AttractionMapper am;
+  am.init(ml);
+
+  mt19937 generator(seed);
+  auto scatter = [&generator, kMaxOffset](const GeoCoord &gc) {
+    double offsets[2];
+    for (int i = 0; i < 2; i++)
+      offsets[i] = (generator() / 4294967296.0 * 2 - 1) * kMaxOffset;
+
+    char latitude[32], longitude[32];
+    snprintf(latitude, sizeof(latitude), "%.7f", gc.latitude + offsets[0]);
+    snprintf(longitude, sizeof(longitude), "%.7f", gc.longitude + offsets[1]);
+    return GeoCoord(latitude, longitude);
+  };
+
+  for (int i = 0; i < pairs.size(); i++) {
+    GeoCoord start, end;
+    am.getGeoCoord(pairs.at(i).start, start);
+    am.getGeoCoord(pairs.at(i).end, end);
+    pairs.at(i).start_point = scatter(start);
+    pairs.at(i).end_point = scatter(end);
+  }
+}
+
+double percentile(const vector<double> &sorted, double fraction) {
+  if (sorted.empty()) return 0;
+
+  int index = fraction * (sorted.size() - 1) + 0.5;
+  return sorted.at(index);
+}
+
+void printRow(const string &mode, int queries, int failures, double total,
+              vector<double> &latencies, const CacheCounters &counters,
+              long long references, long long misses) {
+  sort(latencies.begin(), latencies.end());
+  cout << mode << "," << queries << "," << failures << "," << total << ","
+       << (total > 0 ? queries / total : 0) << ","
+       << percentile(latencies, 0.5) << "," << percentile(latencies, 0.9)
+       << "," << percentile(latencies, 0.99) << ","
+       << (latencies.empty() ? 0 : latencies.back()) << "," << peakRssKb()
+       << ",";
+  if (counters.available() && references > 0) {
+    cout << static_cast<double>(misses) / references << ","
+         << static_cast<double>(misses) / queries;
+  } else {
+    cout << ",";
+  }
+  cout << endl;
+}
+
+void runMode(const string &mode, QueryFunction query, const Navigator &nav,
+             const vector<QueryPair> &pairs, CacheCounters &counters) {
+  vector<double> latencies;
+  latencies.reserve(pairs.size());
+  int failures = 0;
+  long long references, misses;
+
+  chrono::steady_clock::time_point mode_start = chrono::steady_clock::now();
+  counters.start();
+  for (int i = 0; i < pairs.size(); i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (query(nav, pairs.at(i)) != NAV_SUCCESS) failures++;
+    latencies.push_back(secondsSince(start) * 1e6);
+  }
+  counters.stop(references, misses);
+
+  printRow(mode, pairs.size(), failures, secondsSince(mode_start), latencies,
+           counters, references, misses);
+}
+
+// Look up every attraction name, as given and in upper case, a few times
+// over. Lookups are too quick to time one by one, so each latency is the
+// average over a round of all the names.
+void runLookups(const string &map_file, const vector<string> &names,
+                CacheCounters &counters) {
+  const int kRounds = 100;
+
+  MapLoader ml;
+  ml.load(map_file);
+  AttractionMapper am;
+  am.init(ml);
+
+  vector<string> queries = names;
+  for (int i = 0; i < names.size(); i++) {
+    string upper = names.at(i);
+    for (int j = 0; j < upper.size(); j++) upper[j] = toupper(upper[j]);
+    queries.push_back(upper);
+  }
+
+  vector<double> latencies;
+  int failures = 0;
+  GeoCoord gc;
+  long long references, misses;
+
+  chrono::steady_clock::time_point mode_start = chrono::steady_clock::now();
+  counters.start();
+  for (int round = 0; round < kRounds; round++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < queries.size(); i++) {
+      if (!am.getGeoCoord(queries.at(i), gc)) failures++;
+    }
+    latencies.push_back(secondsSince(start) * 1e6 / queries.size());
+  }
+  counters.stop(references, misses);
+
+  printRow("lookup", kRounds * queries.size(), failures,
+           secondsSince(mode_start), latencies, counters, references, misses);
+}
+
+// Snap the start point of every pair to the nearest street, a few times over.
+// Like lookups, each latency is the average over a round of all the points.
+void runSnaps(const Navigator &nav, const vector<QueryPair> &pairs,
+              CacheCounters &counters) {
+  const int kRounds = 100;
+
+  vector<double> latencies;
+  int failures = 0;
+  GeoCoord snapped;
+  StreetSegment segment;
+  long long references, misses;
+
+  chrono::steady_clock::time_point mode_start = chrono::steady_clock::now();
+  counters.start();
+  for (int round = 0; round < kRounds; round++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < pairs.size(); i++) {
+      if (!nav.snapToStreet(pairs.at(i).start_point, snapped, segment))
+        failures++;
+    }
+    latencies.push_back(secondsSince(start) * 1e6 / pairs.size());
+  }
+  counters.stop(references, misses);
+
+  printRow("snap", kRounds * pairs.size(), failures, secondsSince(mode_start),
+           latencies, counters, references, misses);
+}
+
+// Route every pair over a tiled map, and report how many tiles that read.
+void runTiled(const string &tiled_file, size_t max_bytes,
+              const vector<QueryPair> &pairs, CacheCounters &counters) {
+  TiledNavigator tiled;
+  if (!tiled.loadMapData(tiled_file, max_bytes)) {
+    cerr << "Cannot open " << tiled_file << endl;
+    return;
+  }
+
+  vector<double> latencies;
+  latencies.reserve(pairs.size());
+  int failures = 0;
+  long long references, misses;
+  vector<NavSegment> directions;
+
+  chrono::steady_clock::time_point mode_start = chrono::steady_clock::now();
+  counters.start();
+  for (int i = 0; i < pairs.size(); i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (tiled.navigate(pairs.at(i).start, pairs.at(i).end, directions) !=
+        NAV_SUCCESS)
+      failures++;
+    latencies.push_back(secondsSince(start) * 1e6);
+  }
+  counters.stop(references, misses);
+
+  printRow("navigate_tiled", pairs.size(), failures, secondsSince(mode_start),
+           latencies, counters, references, misses);
+  cerr << "navigate_tiled read " << tiled.getMap().getTilesRead()
+       << " tiles and dropped " << tiled.getMap().getTilesDropped() << endl;
+}
+
+int main(int argc, char *argv[]) {
+  string map_file = "mapdata.txt";
+  int num_queries = 200;
+  unsigned seed = 32;
+  string tiled_file;
+  size_t tile_cache_kb = 4096;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc) {
+      num_queries = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-tiles") == 0 && i + 1 < argc) {
+      tiled_file = argv[++i];
+    } else if (strcmp(argv[i], "-tile-cache") == 0 && i + 1 < argc) {
+      tile_cache_kb = strtoul(argv[++i], nullptr, 10);
+    } else if (argv[i][0] != '-') {
+      map_file = argv[i];
+    } else {
+      cerr << "Usage: BruinNavBench [mapdata.txt] [-queries N] [-seed S] "
+              "[-tiles mapdata.bnt] [-tile-cache KB]"
+           << endl;
+      return 1;
+    }
+  }
+
+  vector<string> names = loadAttractionNames(map_file);
+  if (names.empty()) {
+    cerr << "No attractions found in " << map_file << endl;
+    return 1;
+  }
+  vector<QueryPair> pairs = samplePairs(names, num_queries, seed);
+  scatterPoints(map_file, pairs, seed);
+
+  cout << "mode,queries,failures,seconds,queries_per_second,p50_us,p90_us,"
+          "p99_us,max_us,peak_rss_kb,cache_miss_rate,cache_misses_per_query"
+       << endl;
+
+  CacheCounters counters;
+  runLookups(map_file, names, counters);
+
+  Navigator nav;
+  chrono::steady_clock::time_point load_start = chrono::steady_clock::now();
+  if (!nav.loadMapData(map_file)) {
+    cerr << "Cannot load " << map_file << endl;
+    return 1;
+  }
+  double load_seconds = secondsSince(load_start);
+  cout << "load,1,0," << load_seconds << "," << 1 / load_seconds << ","
+       << load_seconds * 1e6 << "," << load_seconds * 1e6 << ","
+       << load_seconds * 1e6 << "," << load_seconds * 1e6 << ","
+       << peakRssKb() << ",," << endl;
+
+  runSnaps(nav, pairs, counters);
+  runMode("navigate", runNavigate, nav, pairs, counters);
+  runMode("navigate_coordinates", runNavigateCoordinates, nav, pairs,
+          counters);
+  runMode("alternatives", runAlternatives, nav, pairs, counters);
+  runMode("reachable", runReachable, nav, pairs, counters);
+  if (!tiled_file.empty())
+    runTiled(tiled_file, tile_cache_kb * 1024, pairs, counters);
+}
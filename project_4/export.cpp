@@ -0,0 +1,116 @@
+// Exports routes for mapping tools. Reads one "Start Attraction|End
+// Attraction" pair per line from standard input, or draws random pairs with
+// -queries, and writes one route per line to standard output. Run it with
+//  ./BruinNavExport [mapdata.txt] [-polyline] [-explored] [-queries N]
+//                   [-seed S]
+// Routes are written as GeoJSON features unless -polyline is given. With
+// GeoJSON, -explored adds a feature with the tree each search explored after
+// each route. Pairs without a route are written with no coordinates, so that
+// output routes line up with input pairs. The export rate is reported on
+// standard error.
+
+#include "provided.h"
+#include "RouteWriter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Flush the buffer to standard output once it holds this many bytes.
+const size_t kFlushBytes = 1 << 20;
+
+int main(int argc, char *argv[]) {
+  string map_file = "mapdata.txt";
+  bool polyline = false, show_explored = false;
+  int num_queries = 0;
+  unsigned seed = 32;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-polyline") == 0) {
+      polyline = true;
+    } else if (strcmp(argv[i], "-explored") == 0) {
+      show_explored = true;
+    } else if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc) {
+      num_queries = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (argv[i][0] != '-') {
+      map_file = argv[i];
+    } else {
+      cerr << "Usage: BruinNavExport [mapdata.txt] [-polyline] [-explored] "
+              "[-queries N] [-seed S]"
+           << endl;
+      return 1;
+    }
+  }
+
+  Navigator nav;
+  if (!nav.loadMapData(map_file)) return 1;
+
+  // Random pairs are drawn the same way as by BruinNavBench.
+  vector<string> names;
+  if (num_queries > 0) {
+    MapLoader ml;
+    ml.load(map_file);
+    for (int i = 0; i < ml.getNumSegments(); i++) {
+      StreetSegment segment;
+      ml.getSegment(i, segment);
+      for (int j = 0; j < segment.attractions.size(); j++)
+        names.push_back(segment.attractions[j].name);
+    }
+    if (names.empty()) return 1;
+  }
+  mt19937 generator(seed);
+
+  RouteWriter writer;
+  vector<NavSegment> directions;
+  vector<GeoSegment> explored;
+  string line, start, end;
+  int routes = 0;
+
+  chrono::steady_clock::time_point export_start = chrono::steady_clock::now();
+  for (int i = 0; num_queries > 0 ? i < num_queries
+                                   : static_cast<bool>(getline(cin, line));
+       i++) {
+    if (num_queries > 0) {
+      start = names.at(generator() % names.size());
+      end = names.at(generator() % names.size());
+    } else {
+      size_t split = line.find('|');
+      start = line.substr(0, split);
+      end = split == string::npos ? "" : line.substr(split + 1);
+    }
+
+    NavResult result = show_explored && !polyline
+                           ? nav.navigate(start, end, directions, explored)
+                           : nav.navigate(start, end, directions);
+    if (result != NAV_SUCCESS) {
+      directions.clear();
+      explored.clear();
+    } else {
+      routes++;
+    }
+
+    if (polyline) {
+      writer.writePolyline(directions);
+    } else {
+      writer.writeGeoJson(start, end, directions);
+      if (show_explored) writer.writeGeoJson(explored);
+    }
+
+    if (writer.size() >= kFlushBytes && !writer.flush(stdout)) return 1;
+  }
+  if (!writer.flush(stdout)) return 1;
+  fflush(stdout);
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            export_start).count();
+  cerr << "Exported " << routes << " routes in " << seconds << " s ("
+       << routes / seconds << " routes/s)" << endl;
+}
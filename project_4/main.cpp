@@ -257,13 +257,29 @@ void printDirections(string start, string end,
 #include <vector>
 #include <cstring>
 using namespace std;
-int main() {
+
+void printStats(const NavStats &stats);
+void printLoadStats(const LoadStats &stats);
+void printAllocCounts(const char *phase, const AllocCounts &counts);
+
+int main(int argc, char *argv[]) {
+  // Pass -stats to print how much work loading and the search did.
+  bool show_stats = argc > 1 && strcmp(argv[1], "-stats") == 0;
+
   Navigator nav;
-  nav.loadMapData("./mapdata.txt");
+  LoadStats load_stats;
+  if (!nav.loadMapData("./mapdata.txt", load_stats)) {
+    cout << "Map data file was not found or has bad format: ./mapdata.txt"
+         << endl;
+    return 1;
+  }
+  if (show_stats) printLoadStats(load_stats);
 
   vector<NavSegment> directions;
+  NavStats stats;
   NavResult nav_return = nav.navigate("Beverly Hills Plaza Hotel & Spa",
-                                      "UCLA Guest House", directions);
+                                      "UCLA Guest House", directions, stats);
+  if (show_stats) printStats(stats);
 
   cout << "Navigation returned " << nav_return << endl;
   for (int i = 0; i < directions.size(); i++) {
@@ -295,3 +311,34 @@ int main() {
          << directions.at(directions.size() - 1).m_geoSegment.end.longitudeText << endl;
 }
 
+void printStats(const NavStats &stats) {
+#ifndef NAV_STATS
+  cout << "Search statistics were not collected; rebuild with make STATS=1"
+       << endl;
+#endif
+  cout << "Nodes popped:     " << stats.nodes_popped << endl
+       << "Edges relaxed:    " << stats.edges_relaxed << endl
+       << "Heap peak size:   " << stats.heap_peak << endl
+       << "Segment lookups:  " << stats.segment_lookups << endl
+       << "Lookup time:      " << stats.lookup_seconds * 1e3 << " ms" << endl
+       << "Search time:      " << stats.search_seconds * 1e3 << " ms" << endl
+       << "Finalize time:    " << stats.finalize_seconds * 1e3 << " ms" << endl;
+  printAllocCounts("Query", stats.heap);
+  cout << endl;
+}
+
+void printLoadStats(const LoadStats &stats) {
+#ifndef ALLOC_STATS
+  cout << "Allocations were not counted; rebuild with make ALLOC_STATS=1"
+       << endl;
+#endif
+  printAllocCounts("Load", stats.load);
+  printAllocCounts("Index", stats.index);
+  cout << endl;
+}
+
+void printAllocCounts(const char *phase, const AllocCounts &counts) {
+  cout << left << setw(18) << string(phase) + " heap:" << counts.allocations
+       << " allocations, " << counts.frees << " frees, " << counts.bytes
+       << " bytes" << endl;
+}
@@ -0,0 +1,147 @@
+// Converts a text map into the compact binary map format (see CompactMap.h),
+// checks that the compact map loads back identical, and compares the size and
+// load speed of the two. Run it with
+//  ./BruinNavPack [mapdata.txt] [mapdata.bnm] [-runs N]
+//                 [-tiles mapdata.bnt] [-tile-size degrees]
+// Either file can then be given to Navigator::loadMapData. With -tiles, a
+// tiled copy (see TiledMap.h) is written as well, for TiledNavigator.
+
+#include "provided.h"
+#include "support.h"
+#include "CompactMap.h"
+#include "TiledMap.h"
+
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+using namespace std;
+
+long fileSize(const string &file) {
+  struct stat info;
+  if (stat(file.c_str(), &info) != 0) return -1;
+  return info.st_size;
+}
+
+// Best time in seconds of several loads of a map, which keeps the file in the
+// page cache so that parsing rather than the disk is measured.
+double timeLoad(const string &map_file, int runs) {
+  double best = 0;
+  for (int i = 0; i < runs; i++) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    MapLoader ml;
+    ml.load(map_file);
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (i == 0 || seconds < best) best = seconds;
+  }
+
+  return best;
+}
+
+bool sameCoord(const GeoCoord &a, const GeoCoord &b) {
+  return a == b && a.latitudeText == b.latitudeText &&
+         a.longitudeText == b.longitudeText;
+}
+
+bool sameSegment(const StreetSegment &a, const StreetSegment &b) {
+  if (a.streetName != b.streetName ||
+      !sameCoord(a.segment.start, b.segment.start) ||
+      !sameCoord(a.segment.end, b.segment.end) ||
+      a.attractions.size() != b.attractions.size())
+    return false;
+
+  for (int i = 0; i < a.attractions.size(); i++) {
+    if (a.attractions[i].name != b.attractions[i].name ||
+        !sameCoord(a.attractions[i].geocoordinates,
+                   b.attractions[i].geocoordinates))
+      return false;
+  }
+
+  return true;
+}
+
+void printRow(const string &format, long bytes, double seconds,
+              size_t segments) {
+  cout << format << "," << bytes << "," << seconds * 1e3 << ","
+       << bytes / seconds / 1e6 << "," << segments / seconds << endl;
+}
+
+int main(int argc, char *argv[]) {
+  string text_file = "mapdata.txt", compact_file = "mapdata.bnm";
+  string tiled_file;
+  double tile_degrees = 0.01;
+  int runs = 5, files = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+      runs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-tiles") == 0 && i + 1 < argc) {
+      tiled_file = argv[++i];
+    } else if (strcmp(argv[i], "-tile-size") == 0 && i + 1 < argc) {
+      tile_degrees = atof(argv[++i]);
+    } else if (argv[i][0] != '-' && files < 2) {
+      (files++ == 0 ? text_file : compact_file) = argv[i];
+    } else {
+      cerr << "Usage: BruinNavPack [mapdata.txt] [mapdata.bnm] [-runs N] "
+              "[-tiles mapdata.bnt] [-tile-size degrees]"
+           << endl;
+      return 1;
+    }
+  }
+
+  MapLoader text;
+  if (!text.load(text_file)) return 1;
+  if (!writeCompactMap(text, compact_file)) {
+    cerr << "Error: Cannot write " << compact_file
+         << " (coordinates must have exactly seven decimals)" << endl;
+    return 1;
+  }
+
+  MapLoader compact;
+  if (!compact.load(compact_file) ||
+      compact.getNumSegments() != text.getNumSegments()) {
+    cerr << "Error: " << compact_file << " does not load back" << endl;
+    return 1;
+  }
+  for (size_t i = 0; i < text.getNumSegments(); i++) {
+    StreetSegment a, b;
+    text.getSegment(i, a);
+    compact.getSegment(i, b);
+    if (!sameSegment(a, b)) {
+      cerr << "Error: Segment " << i << " differs in " << compact_file << endl;
+      return 1;
+    }
+  }
+
+  cout << "format,bytes,load_ms,mb_per_second,segments_per_second" << endl;
+  printRow("text", fileSize(text_file), timeLoad(text_file, runs),
+           text.getNumSegments());
+  printRow("compact", fileSize(compact_file), timeLoad(compact_file, runs),
+           compact.getNumSegments());
+
+  if (!tiled_file.empty()) {
+    if (!writeTiledMap(text, tiled_file, tile_degrees)) {
+      cerr << "Error: Cannot write " << tiled_file << endl;
+      return 1;
+    }
+
+    // Only the directory of a tiled map is read up front.
+    double best = 0;
+    for (int i = 0; i < runs; i++) {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      TiledMap tiled;
+      if (!tiled.open(tiled_file, 0)) {
+        cerr << "Error: " << tiled_file << " does not open" << endl;
+        return 1;
+      }
+      double seconds =
+          chrono::duration<double>(chrono::steady_clock::now() - start)
+              .count();
+      if (i == 0 || seconds < best) best = seconds;
+    }
+    printRow("tiled", fileSize(tiled_file), best, text.getNumSegments());
+  }
+}
@@ -64,7 +64,9 @@ class AttractionMapper {
   AttractionMapper();
   ~AttractionMapper();
   void init(const MapLoader &ml);
-  bool getGeoCoord(std::string attraction, GeoCoord &gc) const;
+  // Add an attraction that is not in the map, or move one that is.
+  void addAttraction(const Attraction &attraction);
+  bool getGeoCoord(const std::string &attraction, GeoCoord &gc) const;
   // We prevent an AttractionMapper object from being copied or assigned.
   AttractionMapper(const AttractionMapper &) = delete;
   AttractionMapper &operator=(const AttractionMapper &) = delete;
@@ -115,6 +117,57 @@ struct NavSegment {
   GeoSegment m_geoSegment;
 };
 
+// Heap allocations made by this thread over some stretch of work. These are
+// only counted when BruinNav is built with ALLOC_STATS defined (make
+// ALLOC_STATS=1), which replaces the global operator new and delete with
+// counting versions (see AllocStats.h), and are left at zero otherwise.
+struct AllocCounts {
+  AllocCounts() : allocations(0), frees(0), bytes(0) {}
+
+  long allocations;  // Calls to operator new.
+  long frees;        // Calls to operator delete, of anything but nullptr.
+  long bytes;        // Bytes asked for by those calls to operator new.
+};
+
+// Allocations made by Navigator::loadMapData, split between reading the map
+// and building the indexes over it.
+struct LoadStats {
+  AllocCounts load;
+  AllocCounts index;
+};
+
+// Work done by a single call to Navigator::navigate. These are only counted
+// when BruinNav is built with NAV_STATS defined (make STATS=1), and are left
+// at zero otherwise.
+struct NavStats {
+  NavStats()
+      : nodes_popped(0),
+        edges_relaxed(0),
+        heap_peak(0),
+        segment_lookups(0),
+        lookup_seconds(0),
+        search_seconds(0),
+        finalize_seconds(0) {}
+
+  long nodes_popped;      // Entries taken off the search queue.
+  long edges_relaxed;     // Entries put on the search queue.
+  long heap_peak;         // Largest size of the search queue.
+  long segment_lookups;   // Calls to SegmentMapper::getSegments.
+  double lookup_seconds;  // Time spent finding the attractions.
+  double search_seconds;  // Time spent searching for the route.
+  double finalize_seconds;  // Time spent turning the route into directions.
+  AllocCounts heap;  // Allocations made by the call (see AllocCounts).
+};
+
+// Everything that can be reached from an attraction within some distance.
+struct Isochrone {
+  std::vector<GeoCoord> intersections;  // Nearest first.
+  std::vector<Attraction> attractions;
+  // Street segments that can be entered but not traveled all the way along,
+  // which together trace the edge of the reachable area.
+  std::vector<StreetSegment> frontier;
+};
+
 enum NavResult {
   NAV_SUCCESS,
   NAV_BAD_SOURCE,
@@ -129,8 +182,41 @@ class Navigator {
   Navigator();
   ~Navigator();
   bool loadMapData(std::string mapFile);
+  // Same as above, also reporting the allocations made while loading.
+  bool loadMapData(std::string mapFile, LoadStats &stats);
+  // Merge consecutive proceeds along the same street into one in the
+  // directions of every route found from now on. Off by default.
+  void setCompactDirections(bool compact);
+  NavResult navigate(std::string start, std::string end,
+                     std::vector<NavSegment> &directions) const;
+  // Same as above, also reporting the work done by the search.
+  NavResult navigate(std::string start, std::string end,
+                     std::vector<NavSegment> &directions,
+                     NavStats &stats) const;
+  // Same as above, also giving the edges of the tree that the search grew, as
+  // segments from each node it settled back to the node it was reached from.
   NavResult navigate(std::string start, std::string end,
+                     std::vector<NavSegment> &directions,
+                     std::vector<GeoSegment> &explored) const;
+  // Find the shortest route between two coordinates, each of which is first
+  // snapped onto the nearest point of the nearest street. Coordinates more
+  // than half a mile from any street are rejected.
+  NavResult navigate(const GeoCoord &start, const GeoCoord &end,
                      std::vector<NavSegment> &directions) const;
+  // Find the nearest point to gc on any street, and the street segment it is
+  // on. Returns false if there is no street within half a mile.
+  bool snapToStreet(const GeoCoord &gc, GeoCoord &snapped,
+                    StreetSegment &segment) const;
+  // Find up to k routes between two attractions, shortest first, where every
+  // route after the first is a reasonable detour that differs substantially
+  // from the routes before it. With k less than 1, no routes are found.
+  NavResult navigateAlternatives(
+      std::string start, std::string end, int k,
+      std::vector<std::vector<NavSegment>> &routes) const;
+  // Find everything that can be reached by traveling at most the given number
+  // of miles from an attraction.
+  NavResult reachableWithin(std::string start, double miles,
+                            Isochrone &area) const;
   // We prevent a Navigator object from being copied or assigned.
   Navigator(const Navigator &) = delete;
   Navigator &operator=(const Navigator &) = delete;
@@ -10,4 +10,13 @@ bool operator==(const GeoCoord &a, const GeoCoord &b);
 bool operator==(const GeoCoord &a, const GeoCoord &b);
 bool operator==(const GeoSegment &a, const GeoSegment &b);
 
+// Search statistics are only gathered when built with NAV_STATS defined.
+// Otherwise every NAV_STAT statement compiles away, leaving the search exactly
+// as it would be without them.
+#ifdef NAV_STATS
+#define NAV_STAT(statement) statement
+#else
+#define NAV_STAT(statement)
+#endif
+
 #endif  // SUPPORT_INCLUDED
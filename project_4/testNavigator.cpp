@@ -0,0 +1,678 @@
+// Differential test for Navigator. Routes a reproducible set of random
+// attraction pairs with both Navigator and a plain reference Dijkstra search
+// over the raw SegmentMapper data, and checks that Navigator's routes are
+// exactly as short as the reference routes and are well formed. Directions
+// are checked against the direction generation that makeDirections replaced.
+// Coordinates are snapped to streets and checked against a search over every
+// segment, and routed between. Routes over a tiled copy of the map are
+// checked against Navigator's routes. MyMap and MyFlatMap, which the indexes
+// are built on, are checked against std::map, NameIndex is checked to refuse
+// names that are equal ignoring case, and allocation counting is checked when
+// it is built in. Corrupt compact and tiled maps are rejected.
+// Run it with
+//  ./testNavigator [mapdata.txt] [-queries N] [-seed S]
+
+#include "provided.h"
+#include "support.h"
+#include "AllocStats.h"
+#include "CompactMap.h"
+#include "Directions.h"
+#include "MyFlatMap.h"
+#include "MyMap.h"
+#include "NameIndex.h"
+#include "TiledMap.h"
+#include "TiledNavigator.h"
+
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+const double kTolerance = 1e-9;  // Miles.
+
+// Shortest distance in miles between two attractions, found by the simplest
+// search possible so that it can be trusted: Dijkstra over coordinates, asking
+// the SegmentMapper for the segments at every coordinate reached. Returns
+// infinity if there is no route.
+double referenceDistance(const SegmentMapper &sm, const GeoCoord &src,
+                         const GeoCoord &dst) {
+  typedef pair<double, GeoCoord> QueueEntry;
+  auto later = [](const QueueEntry &a, const QueueEntry &b) {
+    return a.first > b.first;
+  };
+  priority_queue<QueueEntry, vector<QueueEntry>, decltype(later)> to_visit(
+      later);
+  map<GeoCoord, double> distance;
+  set<GeoCoord> visited;
+
+  distance[src] = 0;
+  to_visit.push(QueueEntry(0, src));
+
+  while (!to_visit.empty()) {
+    QueueEntry current = to_visit.top();
+    to_visit.pop();
+
+    const GeoCoord &coord = current.second;
+    if (coord == dst) return current.first;
+    if (!visited.insert(coord).second) continue;
+
+    vector<StreetSegment> segments = sm.getSegments(coord);
+    for (int i = 0; i < segments.size(); i++) {
+      const StreetSegment &segment = segments.at(i);
+
+      // From any point of a segment we can travel to either of its ends, or
+      // to any attraction on it.
+      vector<GeoCoord> next;
+      next.push_back(segment.segment.start);
+      next.push_back(segment.segment.end);
+      for (int j = 0; j < segment.attractions.size(); j++)
+        next.push_back(segment.attractions.at(j).geocoordinates);
+
+      for (int j = 0; j < next.size(); j++) {
+        double d = current.first + distanceEarthMiles(coord, next.at(j));
+        map<GeoCoord, double>::iterator known = distance.find(next.at(j));
+        if (known != distance.end() && known->second <= d) continue;
+
+        distance[next.at(j)] = d;
+        to_visit.push(QueueEntry(d, next.at(j)));
+      }
+    }
+  }
+
+  return numeric_limits<double>::infinity();
+}
+
+// The direction generation that makeDirections replaced, kept as it was
+// apart from being taken out of NavigatorImpl, which inserted turns as it
+// went and worked out every angle from both of the segments around it.
+string referenceProceedAngleToString(double angle) {
+  angle = fmod(angle, 360.0);
+
+  if (angle < 0 || angle >= 360)
+    return "INVALID";
+  else if (angle <= 22.5)
+    return "east";
+  else if (angle <= 67.5)
+    return "northeast";
+  else if (angle <= 112.5)
+    return "north";
+  else if (angle <= 157.5)
+    return "northwest";
+  else if (angle <= 202.5)
+    return "west";
+  else if (angle <= 247.5)
+    return "southwest";
+  else if (angle <= 292.5)
+    return "south";
+  else if (angle <= 337.5)
+    return "southeast";
+  else if (angle < 360)
+    return "east";
+
+  return "INVALID";
+}
+
+string referenceTurnAngleToString(double angle) {
+  if (angle < 0 || angle >= 360) return "INVALID";
+
+  if (angle < 180) return "left";
+  return "right";
+}
+
+double referenceTrueAngle(GeoSegment &seg1, GeoSegment &seg2) {
+  return angleOfLine(seg1) + angleBetween2Lines(seg1, seg2);
+}
+
+void referenceFinalizeNavSegments(vector<NavSegment> &segments) {
+  for (int i = 0; i < segments.size(); i++) {
+    if (i > 0) {
+      if (segments.at(i).m_streetName != segments.at(i - 1).m_streetName) {
+        double angle = angleBetween2Lines(segments.at(i - 1).m_geoSegment,
+                                          segments.at(i).m_geoSegment);
+
+        NavSegment turn_seg = NavSegment(referenceTurnAngleToString(angle),
+                                         segments.at(i).m_streetName);
+        segments.insert(segments.begin() + i, turn_seg);
+
+        continue;
+      } else {
+        segments.at(i).m_direction =
+            referenceProceedAngleToString(referenceTrueAngle(
+                segments.at(i - 1).m_geoSegment, segments.at(i).m_geoSegment));
+      }
+    } else {
+      GeoSegment &geo_segment = segments.at(i).m_geoSegment;
+      double distance = distanceEarthMiles(geo_segment.start, geo_segment.end);
+
+      segments.at(i).m_distance = distance;
+      segments.at(i).m_direction = referenceProceedAngleToString(
+          angleOfLine(segments.at(i).m_geoSegment));
+    }
+  }
+}
+
+bool sameNavSegment(const NavSegment &a, const NavSegment &b) {
+  if (a.m_command != b.m_command || a.m_direction != b.m_direction ||
+      a.m_streetName != b.m_streetName)
+    return false;
+
+  // Turns have no distance or geo segment.
+  return a.m_command == NavSegment::TURN ||
+         (a.m_distance == b.m_distance &&
+          a.m_geoSegment.start.latitudeText ==
+              b.m_geoSegment.start.latitudeText &&
+          a.m_geoSegment.start.longitudeText ==
+              b.m_geoSegment.start.longitudeText &&
+          a.m_geoSegment.end.latitudeText == b.m_geoSegment.end.latitudeText &&
+          a.m_geoSegment.end.longitudeText == b.m_geoSegment.end.longitudeText);
+}
+
+// Check that makeDirections gives exactly what the function it replaced gave,
+// and that compact directions describe the same route.
+void checkMakeDirections(const vector<NavSegment> &directions) {
+  vector<NavSegment> legs;
+  for (int i = 0; i < directions.size(); i++) {
+    if (directions.at(i).m_command != NavSegment::PROCEED) continue;
+    legs.push_back(directions.at(i));
+    legs.back().m_direction = "";
+  }
+
+  vector<NavSegment> expected = legs, made;
+  referenceFinalizeNavSegments(expected);
+  makeDirections(legs, false, made);
+  assert(made.size() == expected.size());
+  for (int i = 0; i < made.size(); i++)
+    assert(sameNavSegment(made.at(i), expected.at(i)));
+
+  // Compact directions have the same turns, with one proceed around each.
+  vector<NavSegment> compact;
+  makeDirections(legs, true, compact);
+  double total = 0, compact_total = 0;
+  for (int i = 0; i < made.size(); i++) {
+    if (made.at(i).m_command == NavSegment::PROCEED)
+      total += made.at(i).m_distance;
+  }
+
+  int j = 0;
+  for (int i = 0; i < compact.size(); i++) {
+    const NavSegment &segment = compact.at(i);
+    assert(segment.m_command ==
+           (i % 2 == 0 ? NavSegment::PROCEED : NavSegment::TURN));
+    if (segment.m_command == NavSegment::PROCEED) {
+      assert(i == 0 || segment.m_geoSegment.start ==
+                           compact.at(i - 2).m_geoSegment.end);
+      compact_total += segment.m_distance;
+      continue;
+    }
+
+    while (made.at(j).m_command != NavSegment::TURN) j++;
+    assert(sameNavSegment(segment, made.at(j++)));
+  }
+  assert(compact.back().m_geoSegment.end == made.back().m_geoSegment.end);
+  assert(fabs(total - compact_total) < kTolerance);
+}
+
+// Check that a list of directions is a connected route from src to dst, and
+// return its total length.
+double checkDirections(const vector<NavSegment> &directions,
+                       const GeoCoord &src, const GeoCoord &dst) {
+  assert(!directions.empty());
+  assert(directions.front().m_command == NavSegment::PROCEED);
+  assert(directions.back().m_command == NavSegment::PROCEED);
+
+  double total = 0;
+  const NavSegment *previous = nullptr;
+  for (int i = 0; i < directions.size(); i++) {
+    const NavSegment &segment = directions.at(i);
+
+    if (segment.m_command == NavSegment::TURN) {
+      // A turn sits between two proceeds and names the street turned onto.
+      assert(previous != nullptr && i + 1 < directions.size());
+      assert(directions.at(i + 1).m_command == NavSegment::PROCEED);
+      assert(segment.m_streetName == directions.at(i + 1).m_streetName);
+      assert(segment.m_streetName != previous->m_streetName);
+      assert(segment.m_direction == "left" || segment.m_direction == "right");
+      continue;
+    }
+
+    // Every proceed picks up where the last one left off.
+    const GeoSegment &gs = segment.m_geoSegment;
+    assert(previous != nullptr ? previous->m_geoSegment.end == gs.start
+                               : gs.start == src);
+    assert(fabs(segment.m_distance - distanceEarthMiles(gs.start, gs.end)) <
+           kTolerance);
+    assert(!segment.m_direction.empty() && segment.m_direction != "INVALID");
+
+    // Streets only change at turns.
+    if (previous != nullptr && directions.at(i - 1).m_command != NavSegment::TURN)
+      assert(segment.m_streetName == previous->m_streetName);
+
+    total += segment.m_distance;
+    previous = &segment;
+  }
+
+  assert(previous->m_geoSegment.end == dst);
+  return total;
+}
+
+// Distance in miles from gc to the nearest point of any segment, found by
+// looking at every segment, on the same flat projection that snapping uses.
+double referenceSnapDistance(const MapLoader &ml, const GeoCoord &gc) {
+  const double kMilesPerDegree = 6371.0 * 0.621371 * M_PI / 180;
+  double scale = cos(deg2rad(gc.latitude));
+  double best = numeric_limits<double>::infinity();
+
+  for (int i = 0; i < ml.getNumSegments(); i++) {
+    StreetSegment segment;
+    ml.getSegment(i, segment);
+    const GeoCoord &a = segment.segment.start, &b = segment.segment.end;
+
+    double ax = (a.longitude - gc.longitude) * scale;
+    double ay = a.latitude - gc.latitude;
+    double dx = (b.longitude - a.longitude) * scale;
+    double dy = b.latitude - a.latitude;
+    double t = dx * dx + dy * dy > 0
+                   ? -(ax * dx + ay * dy) / (dx * dx + dy * dy)
+                   : 0;
+    t = min(max(t, 0.0), 1.0);
+    best = min(best, hypot(ax + t * dx, ay + t * dy) * kMilesPerDegree);
+  }
+
+  return best;
+}
+
+// Whether gc snaps to itself on the only segment it is listed on.
+bool onlySegment(const Navigator &nav, const SegmentMapper &sm,
+                 const GeoCoord &gc) {
+  vector<StreetSegment> segments = sm.getSegments(gc);
+  GeoCoord snapped;
+  StreetSegment segment;
+  return segments.size() == 1 && nav.snapToStreet(gc, snapped, segment) &&
+         snapped == gc && segment.segment == segments.front().segment;
+}
+
+// Check that MyMap and MyFlatMap hold the same entries as std::map, however
+// they are filled, and that MyMap gives them back in order.
+void checkMyMap(unsigned seed) {
+  mt19937 generator(seed);
+  vector<pair<int, int>> entries;
+  map<int, int> expected;
+  for (int i = 0; i < 1000; i++) {
+    entries.push_back(make_pair(generator() % 500, i));
+    expected[entries.back().first] = i;
+  }
+
+  MyMap<int, int> associated, inserted;
+  for (int i = 0; i < entries.size(); i++) {
+    associated.associate(entries.at(i).first, entries.at(i).second);
+    int &value = inserted.findOrInsert(entries.at(i).first, -1);
+    if (value == -1) value = entries.at(i).second;
+  }
+  MyMap<int, int> loaded(entries.begin(), entries.end());
+
+  // A flat map only sees what was staged before the last freeze, and entries
+  // staged later replace those frozen before.
+  MyFlatMap<int, int> flat(entries.begin(), entries.begin() + 500);
+  for (int i = 500; i < entries.size(); i++)
+    flat.associate(entries.at(i).first, entries.at(i).second);
+  assert(flat.find(entries.back().first) == nullptr ||
+         *flat.find(entries.back().first) != entries.back().second);
+  flat.freeze();
+  assert(flat.size() == expected.size());
+
+  // Bulk loading and associating keep the last value given for each key,
+  // and findOrInsert keeps the first.
+  assert(associated.size() == expected.size());
+  assert(loaded.size() == expected.size());
+  assert(inserted.size() == expected.size());
+  map<int, int>::const_iterator e = expected.begin();
+  MyMap<int, int>::const_iterator a = associated.begin(), l = loaded.begin();
+  for (; e != expected.end(); e++, a++, l++) {
+    assert(a->first == e->first && a->second == e->second);
+    assert(l->first == e->first && l->second == e->second);
+    assert(*loaded.find(e->first) == e->second);
+    assert(*flat.find(e->first) == e->second);
+    assert(*inserted.find(e->first) <= e->second);
+  }
+  assert(a == associated.end() && l == loaded.end());
+  assert(loaded.find(500) == nullptr);
+  for (int key = -1; key <= 500; key++)
+    assert((flat.find(key) == nullptr) == (expected.count(key) == 0));
+}
+
+// A name index finds each of its names ignoring case, and fails to build,
+// leaving itself empty, from names that are equal ignoring case.
+void checkNameIndex() {
+  NameIndex index;
+  vector<string> names = {"Foo", "Bar", "Baz Qux"};
+  bool built = index.build(names);
+  assert(built && index.size() == names.size());
+  for (int i = 0; i < names.size(); i++)
+    assert(index.find(names.at(i)) == index.getPosition(i));
+  assert(index.find("BAR") == index.getPosition(1));
+  assert(index.find("Quux") == -1);
+
+  built = index.build({"Foo", "foo"});
+  assert(!built && index.size() == 0);
+  assert(index.find("foo") == -1);
+}
+
+// With ALLOC_STATS defined, an AllocScope sees exactly the allocations made
+// inside it. Without it, it sees none.
+void checkAllocScope() {
+  AllocScope allocs;
+  // The pointer is volatile so that the compiler cannot leave out the pair.
+  int *volatile block = new int[100];
+  delete[] block;
+  AllocCounts counts = allocs.counts();
+#ifdef ALLOC_STATS
+  assert(counts.allocations == 1 && counts.frees == 1);
+  assert(counts.bytes == 100 * sizeof(int));
+#else
+  assert(counts.allocations == 0 && counts.frees == 0 && counts.bytes == 0);
+#endif
+}
+
+// Write bytes to a file, replacing it.
+void writeFile(const string &file, const string &bytes) {
+  FILE *out = fopen(file.c_str(), "wb");
+  assert(out != nullptr);
+  size_t written = fwrite(bytes.data(), 1, bytes.size(), out);
+  assert(written == bytes.size());
+  fclose(out);
+}
+
+// Whether every segment of a compact map file decodes.
+bool decodesCompactMap(const string &file) {
+  CompactMapReader reader;
+  if (!reader.open(file)) return false;
+
+  StreetSegment segment;
+  for (size_t i = 0; i < reader.getNumSegments(); i++) {
+    if (!reader.next(segment)) return false;
+  }
+  return true;
+}
+
+// Compact maps that are cut short, or that claim more names, segments or
+// attractions than the file holds, fail to decode instead of being sized from
+// those counts, and Navigator fails to load them.
+void checkCorruptCompactMap(const MapLoader &ml) {
+  vector<StreetSegment> segments;
+  for (size_t i = 0; i < ml.getNumSegments() && i < 50; i++) {
+    StreetSegment segment;
+    ml.getSegment(i, segment);
+    segments.push_back(segment);
+  }
+  string map;
+  bool encoded = encodeCompactMap(segments, map);
+  assert(encoded);
+
+  const string file = "testNavigator.bnm";
+  writeFile(file, map);
+  assert(decodesCompactMap(file));
+  for (size_t length = 0; length < map.size(); length++) {
+    writeFile(file, map.substr(0, length));
+    assert(!decodesCompactMap(file));
+  }
+
+  // A count of 2^62, as a varint.
+  const string huge("\xff\xff\xff\xff\xff\xff\xff\xff\x3f", 9);
+  const string magic(kCompactMapMagic, kCompactMapMagicLength);
+  writeFile(file, magic + huge);  // Names.
+  assert(!decodesCompactMap(file));
+  writeFile(file, magic + "\x01" + huge);  // Length of a name.
+  assert(!decodesCompactMap(file));
+  writeFile(file, magic + '\0' + huge);  // Segments.
+  assert(!decodesCompactMap(file));
+  MapLoader loader;
+  assert(!loader.load(file));
+  Navigator nav;
+  assert(!nav.loadMapData(file));
+  // Attractions of a segment named "a" from (0, 0) to (0, 0).
+  writeFile(file, magic + "\x01\x01" "a\x01" + string(5, '\0') + huge);
+  assert(!decodesCompactMap(file));
+  remove(file.c_str());
+}
+
+// Tiled maps whose header or names are cut short or claim more than the file
+// holds fail to open instead of being sized from those counts.
+void checkCorruptTiledMap(const string &tiled_file) {
+  FILE *in = fopen(tiled_file.c_str(), "rb");
+  assert(in != nullptr);
+  string map(512, '\0');
+  map.resize(fread(&map[0], 1, map.size(), in));
+  fclose(in);
+
+  const string file = "testNavigator-corrupt.bnt";
+  TiledMap tiled;
+  for (size_t length = 0; length < 16; length++) {
+    writeFile(file, map.substr(0, length));
+    assert(!tiled.open(file, 0));
+  }
+
+  // A count of 2^62, as a varint, and a tile size, origin, columns and rows
+  // of one each.
+  const string huge("\xff\xff\xff\xff\xff\xff\xff\xff\x3f", 9);
+  const string magic(kTiledMapMagic, kTiledMapMagicLength);
+  const string one("\x01", 1);
+  const string header = magic + one + one + one + one + one;
+  writeFile(file, magic + '\0' + one + one + one + one + '\0' + one);
+  assert(!tiled.open(file, 0));  // Tiles of no size.
+  writeFile(file, magic + one + one + one + huge + one + '\0' + one);
+  assert(!tiled.open(file, 0));  // Columns.
+  writeFile(file, magic + one + one + one + huge + huge + '\0' + one);
+  assert(!tiled.open(file, 0));  // Columns times rows.
+  writeFile(file, header + huge + '\0');
+  assert(!tiled.open(file, 0));  // Names.
+  writeFile(file, header + one + huge + '\0');
+  assert(!tiled.open(file, 0));  // Length of a name.
+  const string foo = string("\x03" "Foo") + '\0';  // In the first tile.
+  writeFile(file, header + "\x02" + foo + "\x03" "foo" + '\0' + '\0');
+  assert(!tiled.open(file, 0));  // Names that are equal ignoring case.
+  writeFile(file, header + one + foo + '\0');
+  assert(tiled.open(file, 0));  // A single empty tile is fine.
+  remove(file.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  string map_file = "mapdata.txt";
+  int num_queries = 1000;
+  unsigned seed = 32;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-queries") == 0 && i + 1 < argc)
+      num_queries = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+      seed = strtoul(argv[++i], nullptr, 10);
+    else
+      map_file = argv[i];
+  }
+
+  checkMyMap(seed);
+  checkNameIndex();
+  checkAllocScope();
+
+  // The loads are kept out of assert so that the test still has a map to
+  // route over when built with NDEBUG.
+  MapLoader ml;
+  bool loaded = ml.load(map_file);
+  assert(loaded);
+  AttractionMapper am;
+  am.init(ml);
+  SegmentMapper sm;
+  sm.init(ml);
+  Navigator nav;
+  loaded = nav.loadMapData(map_file);
+  assert(loaded);
+  checkCorruptCompactMap(ml);
+
+  vector<string> names;
+  for (int i = 0; i < ml.getNumSegments(); i++) {
+    StreetSegment segment;
+    ml.getSegment(i, segment);
+    for (int j = 0; j < segment.attractions.size(); j++)
+      names.push_back(segment.attractions.at(j).name);
+  }
+  assert(!names.empty());
+
+  // Unknown attractions are reported as such.
+  vector<NavSegment> directions;
+  assert(nav.navigate("No Such Place", names.front(), directions) ==
+         NAV_BAD_SOURCE);
+  assert(nav.navigate(names.front(), "No Such Place", directions) ==
+         NAV_BAD_DESTINATION);
+
+  mt19937 generator(seed);
+  int routed = 0;
+  for (int i = 0; i < num_queries; i++) {
+    string start = names.at(generator() % names.size());
+    string end = names.at(generator() % names.size());
+
+    GeoCoord src, dst;
+    assert(am.getGeoCoord(start, src) && am.getGeoCoord(end, dst));
+    double expected = referenceDistance(sm, src, dst);
+
+    NavResult result = nav.navigate(start, end, directions);
+    if (expected == numeric_limits<double>::infinity()) {
+      assert(result == NAV_NO_ROUTE);
+      continue;
+    }
+
+    assert(result == NAV_SUCCESS);
+    double total = checkDirections(directions, src, dst);
+    checkMakeDirections(directions);
+
+    // Compact directions keep the turns and merge the proceeds between them.
+    vector<NavSegment> compact;
+    nav.setCompactDirections(true);
+    assert(nav.navigate(start, end, compact) == NAV_SUCCESS);
+    nav.setCompactDirections(false);
+    int turns = 0;
+    for (int j = 0; j < directions.size(); j++)
+      turns += directions.at(j).m_command == NavSegment::TURN;
+    assert(compact.size() == 2 * turns + 1);
+    if (fabs(total - expected) > kTolerance) {
+      cerr << start << " -> " << end << ": " << total << " miles, expected "
+           << expected << endl;
+      assert(false);
+    }
+
+    // Routing between the coordinates of attractions goes just as far, as
+    // long as each attraction is on a single segment and lies on it.
+    if (onlySegment(nav, sm, src) && onlySegment(nav, sm, dst)) {
+      vector<NavSegment> snapped;
+      assert(nav.navigate(src, dst, snapped) == NAV_SUCCESS);
+      assert(fabs(checkDirections(snapped, src, dst) - expected) < kTolerance);
+    }
+
+    // The first alternative route is the shortest route.
+    vector<vector<NavSegment>> routes;
+    assert(nav.navigateAlternatives(start, end, 3, routes) == NAV_SUCCESS);
+    assert(!routes.empty() && routes.size() <= 3);
+    assert(fabs(checkDirections(routes.front(), src, dst) - expected) <
+           kTolerance);
+    for (int j = 1; j < routes.size(); j++)
+      assert(checkDirections(routes.at(j), src, dst) >= expected - kTolerance);
+    assert(nav.navigateAlternatives(start, end, 0, routes) == NAV_SUCCESS);
+    assert(routes.empty());
+
+    routed++;
+  }
+
+  // Coordinates far from every street are rejected.
+  GeoCoord nowhere("0", "0"), somewhere;
+  assert(am.getGeoCoord(names.front(), somewhere));
+  assert(nav.navigate(nowhere, somewhere, directions) == NAV_BAD_SOURCE);
+  assert(nav.navigate(somewhere, nowhere, directions) == NAV_BAD_DESTINATION);
+
+  // Coordinates near attractions snap to the nearest street, and can be
+  // routed between.
+  int snapped_routes = 0;
+  for (int i = 0; i < num_queries / 10; i++) {
+    GeoCoord points[2], snapped[2];
+    for (int j = 0; j < 2; j++) {
+      GeoCoord gc;
+      am.getGeoCoord(names.at(generator() % names.size()), gc);
+      uniform_real_distribution<double> jitter(-0.002, 0.002);
+      char latitude[32], longitude[32];
+      snprintf(latitude, sizeof(latitude), "%.7f",
+               gc.latitude + jitter(generator));
+      snprintf(longitude, sizeof(longitude), "%.7f",
+               gc.longitude + jitter(generator));
+      points[j] = GeoCoord(latitude, longitude);
+
+      // The snapped point is on the segment given, and is as near as the
+      // nearest point of any segment.
+      StreetSegment segment;
+      assert(nav.snapToStreet(points[j], snapped[j], segment));
+      const GeoSegment &gs = segment.segment;
+      assert(fabs(distanceEarthMiles(gs.start, snapped[j]) +
+                  distanceEarthMiles(snapped[j], gs.end) -
+                  distanceEarthMiles(gs.start, gs.end)) < 1e-6);
+      assert(distanceEarthMiles(points[j], snapped[j]) <=
+             referenceSnapDistance(ml, points[j]) * 1.001 + 1e-5);
+    }
+
+    NavResult result = nav.navigate(points[0], points[1], directions);
+    if (result == NAV_NO_ROUTE) continue;
+    assert(result == NAV_SUCCESS);
+    checkDirections(directions, snapped[0], snapped[1]);
+    snapped_routes++;
+  }
+
+  // Routes over a tiled copy of the map, with room for only a few tiles at a
+  // time, are just as short.
+  const string tiled_file = "testNavigator.bnt";
+  const size_t kMaxTileBytes = 1 << 20;
+  bool written = writeTiledMap(ml, tiled_file, 0.01);
+  assert(written);
+  TiledNavigator tiled;
+  loaded = tiled.loadMapData(tiled_file, kMaxTileBytes);
+  assert(loaded);
+  checkCorruptTiledMap(tiled_file);
+  assert(tiled.navigate("No Such Place", names.front(), directions) ==
+         NAV_BAD_SOURCE);
+
+  int tiled_routes = 0;
+  for (int i = 0; i < num_queries / 20; i++) {
+    string start = names.at(generator() % names.size());
+    string end = names.at(generator() % names.size());
+    GeoCoord src, dst;
+    assert(am.getGeoCoord(start, src) && am.getGeoCoord(end, dst));
+
+    vector<NavSegment> tiled_directions;
+    NavResult result = nav.navigate(start, end, directions);
+    assert(tiled.navigate(start, end, tiled_directions) == result);
+    const TiledMap &map = tiled.getMap();
+    assert(map.getBytesHeld() <= kMaxTileBytes ||
+           map.getTilesRead() - map.getTilesDropped() == 1);
+    if (result != NAV_SUCCESS) continue;
+
+    assert(fabs(checkDirections(tiled_directions, src, dst) -
+                checkDirections(directions, src, dst)) < kTolerance);
+    tiled_routes++;
+  }
+  assert(tiled.getMap().getTilesDropped() > 0);
+  remove(tiled_file.c_str());
+
+  cout << "Routed " << routed << " of " << num_queries << " pairs" << endl;
+  cout << "Routed " << snapped_routes << " of " << num_queries / 10
+       << " coordinate pairs" << endl;
+  cout << "Routed " << tiled_routes << " of " << num_queries / 20
+       << " pairs over tiles" << endl;
+  cout << "Passed all tests" << endl;
+}